@@ -0,0 +1,51 @@
+#pragma once
+#include <cstdint>
+#include <vector>
+#include "depth_frame.hpp"
+
+/*
+    BackgroundModel class
+    Modèle du sol pixel par pixel sur le buffer compact d'une DepthFrame : moyenne
+    et écart type de chaque pixel sur les trames accumulées pendant la calibration.
+    Le seuil de chaque pixel vaut noise_k écarts types (au moins min_threshold).
+    extract() produit ensuite à chaque trame l'image de hauteur au-dessus du sol,
+    dans l'unité de la trame : fond - profondeur, 0 sous le seuil de bruit,
+    NO_VALUE si le pixel ou son fond est invalide.
+*/
+class BackgroundModel
+{
+public:
+    static constexpr uint16_t NO_VALUE = UINT16_MAX;
+
+    BackgroundModel(DepthFrame const &frame, uint16_t valid_max, float noise_k, uint16_t min_threshold);
+
+    // Recommence l'accumulation
+    void reset();
+    // Ajoute la trame courante au modèle
+    void accumulate();
+    // Calcule fond et seuils : un pixel valide sur moins de la moitié des trames n'a pas de fond
+    void finish();
+
+    // Image de hauteur de la trame courante, en un passage vectorisé
+    void extract();
+
+    inline uint16_t const *get_background() const { return background.data(); }
+    inline uint16_t const *get_heights() const { return heights.data(); }
+
+    // proportion de pixels du ROI qui ont un fond, et écart type moyen de ces pixels
+    inline float get_coverage() const { return coverage; }
+    inline float get_noise() const { return noise; }
+
+private:
+    DepthFrame const &frame;
+    uint16_t valid_max;
+    float noise_k;
+    uint16_t min_threshold;
+
+    uint16_t frames = 0;
+    std::vector<uint32_t> sum, sum_sq;
+    std::vector<uint16_t> count;
+
+    std::vector<uint16_t> background, threshold, heights;
+    float coverage = 0, noise = 0;
+};
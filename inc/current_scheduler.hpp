@@ -0,0 +1,47 @@
+#pragma once
+#include <cstdint>
+#include <vector>
+
+/*
+    CurrentScheduler class
+    Répartit à chaque tick le courant d'une alimentation entre les moteurs qu'elle
+    porte (motors_per_supply moteurs consécutifs par alimentation). Le courant d'un
+    moteur est supposé proportionnel à son rapport cyclique (run_a à duty_max, les
+    impulsions étant décalées par PwmBank), plus inrush_a le tick où il démarre.
+    Les moteurs déjà lancés passent d'abord (un arrêt suivi d'un redémarrage coûte un
+    nouvel appel de courant), puis ceux dont le profil a le plus de temps restant :
+    le plus long déplacement fixe la durée de la transition, il doit partir en premier.
+    Un moteur qui ne tient pas dans le reste du budget est bridé à la plus forte
+    commande qui y tient, ou différé si elle est sous duty_min.
+*/
+class CurrentScheduler
+{
+public:
+    CurrentScheduler(int motors, int motors_per_supply, float budget_a, float run_a, float inrush_a,
+                     uint16_t duty_min, uint16_t duty_max);
+
+    /**
+     * Réduit les commandes du tick pour respecter le budget de chaque alimentation
+     * @param duty commandes signées demandées par les profils, modifiées sur place (0 : différé)
+     * @param remaining_s temps restant du profil de chaque moteur
+     * @param running moteur déjà en marche au tick précédent (pas d'appel de courant)
+     */
+    void schedule(int16_t *duty, float const *remaining_s, bool const *running);
+
+    // courant estimé d'un moteur à cette commande
+    float current(uint16_t duty, bool running) const;
+
+    inline uint64_t get_deferred() const { return deferred; }
+    inline uint64_t get_limited() const { return limited; }
+    // plus forte charge d'une alimentation après arbitrage
+    inline float get_peak_a() const { return peak_a; }
+
+private:
+    int motors, motors_per_supply;
+    float budget_a, run_a, inrush_a;
+    uint16_t duty_min, duty_max;
+    std::vector<int> order;
+    std::vector<float> load;
+    uint64_t deferred = 0, limited = 0;
+    float peak_a = 0;
+};
@@ -0,0 +1,75 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+// Taille d'une trame de profondeur Kinect (FREENECT_RESOLUTION_MEDIUM)
+#define KINECT_W 640
+#define KINECT_H 480
+
+// Rectangle en coordonnées de l'image complète
+struct Rect
+{
+    int x, y, w, h;
+};
+
+/*
+    DepthFrame class
+    Trame de profondeur réduite à la région utile (ROI) : seules les lignes et les
+    colonnes couvertes par au moins un rectangle (les fenêtres des zones moteur)
+    sont copiées depuis la trame libfreenect, dans un buffer compact.
+    Les pixels restent adressés en coordonnées de l'image complète.
+*/
+class DepthFrame
+{
+public:
+    DepthFrame(std::vector<Rect> const &rects);
+
+    // Copie les lignes/colonnes du ROI depuis une trame complète KINECT_W x KINECT_H,
+    // à appeler dès le retour de freenect : l'heure de réception est relevée ici
+    void capture(uint16_t const *full, uint32_t timestamp);
+
+    // Pixel (x, y) de l'image complète, qui doit être dans le ROI
+    inline uint16_t at(int x, int y) const { return data[row_of[y] * width + col_of[x]]; }
+
+    // Ligne compacte contenant la ligne y de l'image, à indexer par col(x)
+    inline uint16_t const *line(int y) const { return &data[row_of[y] * width]; }
+    inline int col(int x) const { return col_of[x]; }
+    inline int row(int y) const { return row_of[y]; }
+
+    // vrai si le pixel (x, y) de l'image est dans le ROI
+    inline bool contains(int x, int y) const
+    {
+        return x >= 0 && x < KINECT_W && y >= 0 && y < KINECT_H && row_of[y] >= 0 && col_of[x] >= 0;
+    }
+
+    // Taille du buffer compact
+    inline int get_width() const { return width; }
+    inline int get_height() const { return height; }
+    inline uint16_t const *get_data() const { return data.data(); }
+    // horodatage de la Kinect (horloge du capteur) et heure de réception (CLOCK_MONOTONIC, µs)
+    inline uint32_t get_timestamp() const { return timestamp; }
+    inline uint64_t get_time_us() const { return time_us; }
+
+    // Octets copiés par trame, et octets d'une trame complète pour comparaison
+    inline size_t bytes_per_frame() const { return data.size() * sizeof(uint16_t); }
+    static constexpr size_t FULL_FRAME_BYTES = KINECT_W * KINECT_H * sizeof(uint16_t);
+
+private:
+    // colonnes consécutives du ROI
+    struct Span
+    {
+        int from, len;
+    };
+
+    int width, height;
+    std::vector<Span> col_spans;
+    std::vector<int> rows;
+    // index compact de chaque ligne/colonne de l'image, -1 hors ROI
+    int16_t row_of[KINECT_H];
+    int16_t col_of[KINECT_W];
+
+    std::vector<uint16_t> data;
+    uint32_t timestamp;
+    uint64_t time_us;
+};
@@ -0,0 +1,73 @@
+#pragma once
+
+#include <linux/i2c-dev.h>
+#include <linux/i2c.h>
+#include <cstdint>
+#include <cstdio>
+#include <mutex>
+#include <string>
+#include "i2c_executor.hpp"
+
+// bus par défaut, spécifique au raspberry pi
+#define I2C_DEVICE "/dev/i2c-1"
+
+/*
+    I2C_bus class
+    Un bus i2c (/dev/i2c-N) : son descripteur de fichier, le nombre de périphériques
+    qui l'utilisent et son thread propriétaire (I2C_executor). Chaque bus a son
+    propre thread, les transactions de deux bus différents se font donc en parallèle
+    (le Pi 4 expose /dev/i2c-1, -3, -4, -5, -6).
+    Les instances sont partagées : une par chemin, ouverte à la première référence
+    et fermée quand plus aucun périphérique ne l'utilise.
+*/
+class I2C_bus
+{
+public:
+    /**
+     * Retourne le bus du chemin donné en l'ouvrant si besoin, et compte une référence
+     * @return nullptr si le bus ne peut pas être ouvert (errno indique l'erreur)
+     */
+    static I2C_bus *acquire(const char *path = I2C_DEVICE);
+
+    // Rend une référence, le bus est fermé à la dernière
+    static void release(I2C_bus *bus);
+
+    // Démarre/arrête le thread de chaque bus ouvert
+    static void start_all();
+    static void stop_all();
+
+    // Affiche les statistiques de chaque bus ouvert
+    static void print_stats_all();
+
+    /**
+     * Envoie nmsgs messages (éventuellement à des adresses différentes).
+     * Si le thread du bus tourne, la transaction passe par sa file de priorité.
+     * @return true si tous les messages ont été acquittés, false sinon avec errno modifié
+     */
+    bool transfer(struct i2c_msg *msgs, uint32_t nmsgs, I2C_priority priority);
+
+    inline const char *get_path() const { return path.c_str(); }
+    inline int get_fd() const { return fd; }
+    inline I2C_executor *get_executor() { return executor; }
+
+private:
+    I2C_bus(const char *path);
+    ~I2C_bus();
+
+    bool open_bus();
+    bool close_bus();
+
+    std::string path;
+    // descripteur du bus, -1 tant qu'il n'est pas ouvert
+    int fd;
+    // nombre de périphériques utilisant le bus
+    uint32_t dev_ctn;
+    I2C_executor *executor;
+
+    // bus ouverts ; tableau simple pour rester utilisable pendant la destruction
+    // des objets statiques (ex: le PCA9685 global de main.cpp)
+    static constexpr int MAX_BUSES = 8;
+    static I2C_bus *buses[MAX_BUSES];
+    static int nb_buses;
+    static std::mutex buses_mutex;
+};
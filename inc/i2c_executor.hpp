@@ -0,0 +1,207 @@
+#pragma once
+
+#include <linux/i2c-dev.h>
+#include <linux/i2c.h>
+#include <semaphore.h>
+#include <atomic>
+#include <csignal>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <future>
+#include <mutex>
+#include <thread>
+
+// Classes de priorité des transactions, de la plus urgente à la moins urgente
+enum I2C_priority
+{
+    I2C_PRIO_EMERGENCY,  // arrêt d'urgence des moteurs
+    I2C_PRIO_ACTUATION,  // commandes PWM
+    I2C_PRIO_SENSOR,     // lectures des capteurs
+    I2C_PRIO_DIAGNOSTIC, // init, calibration, tests
+    I2C_PRIO_COUNT
+};
+
+/*
+    File bornée multi-producteurs sans verrou (algorithme de D. Vyukov).
+    Chaque case porte un numéro de séquence qui indique si elle est libre
+    pour le producteur du tour courant ou prête pour le consommateur.
+    N doit être une puissance de 2.
+*/
+template <typename T, size_t N>
+class LockFreeQueue
+{
+    static_assert((N & (N - 1)) == 0, "N doit être une puissance de 2");
+
+public:
+    LockFreeQueue()
+    {
+        for (size_t i = 0; i < N; i++)
+            cells[i].seq.store(i, std::memory_order_relaxed);
+    }
+
+    // @return false si la file est pleine
+    bool push(T &&value)
+    {
+        size_t pos = tail.load(std::memory_order_relaxed);
+        for (;;)
+        {
+            Cell &cell = cells[pos & (N - 1)];
+            intptr_t diff = (intptr_t)cell.seq.load(std::memory_order_acquire) - (intptr_t)pos;
+            if (diff == 0)
+            {
+                if (tail.compare_exchange_weak(pos, pos + 1, std::memory_order_relaxed))
+                {
+                    cell.data = std::move(value);
+                    cell.seq.store(pos + 1, std::memory_order_release);
+                    return true;
+                }
+            }
+            else if (diff < 0)
+                return false;
+            else
+                pos = tail.load(std::memory_order_relaxed);
+        }
+    }
+
+    // @return false si la file est vide
+    bool pop(T &value)
+    {
+        size_t pos = head.load(std::memory_order_relaxed);
+        for (;;)
+        {
+            Cell &cell = cells[pos & (N - 1)];
+            intptr_t diff = (intptr_t)cell.seq.load(std::memory_order_acquire) - (intptr_t)(pos + 1);
+            if (diff == 0)
+            {
+                if (head.compare_exchange_weak(pos, pos + 1, std::memory_order_relaxed))
+                {
+                    value = std::move(cell.data);
+                    cell.seq.store(pos + N, std::memory_order_release);
+                    return true;
+                }
+            }
+            else if (diff < 0)
+                return false;
+            else
+                pos = head.load(std::memory_order_relaxed);
+        }
+    }
+
+    // nombre approximatif d'éléments en attente
+    size_t size() const
+    {
+        size_t t = tail.load(std::memory_order_relaxed);
+        size_t h = head.load(std::memory_order_relaxed);
+        return t > h ? t - h : 0;
+    }
+
+private:
+    struct Cell
+    {
+        std::atomic<size_t> seq;
+        T data;
+    };
+    Cell cells[N];
+    alignas(64) std::atomic<size_t> head{0};
+    alignas(64) std::atomic<size_t> tail{0};
+};
+
+/*
+    I2C_executor class
+    Thread propriétaire d'un bus i2c : les clients déposent leurs transactions
+    dans une file par classe de priorité, le thread les exécute toujours en
+    commençant par la classe la plus urgente. Une commande moteur n'attend donc
+    jamais derrière une file de lectures capteurs, seulement derrière la
+    transaction en cours.
+*/
+class I2C_executor
+{
+public:
+    // fd : descripteur du bus déjà ouvert (l'executor ne le ferme pas)
+    I2C_executor(int fd);
+    ~I2C_executor();
+
+    void start();
+    void stop();
+    inline bool running() const { return worker_id.load() != std::thread::id(); }
+
+    /**
+     * Dépose une transaction. Les messages (et leurs buffers) doivent rester valides
+     * jusqu'à ce que le futur soit prêt.
+     * @return futur qui vaut true si tous les messages ont été acquittés
+     */
+    std::future<bool> submit(I2C_priority priority, struct i2c_msg *msgs, uint32_t nmsgs);
+
+    /**
+     * Variante avec callback, appelée depuis le thread de l'executor à la fin de la transaction
+     * @return false si la file est pleine (callback non appelé)
+     */
+    bool submit(I2C_priority priority, struct i2c_msg *msgs, uint32_t nmsgs, std::function<void(bool)> callback);
+
+    /**
+     * Exécute une transaction et attend sa fin. Appelé depuis le thread de l'executor
+     * (dans un callback) ou executor arrêté, la transaction est faite directement,
+     * sous le même verrou que celles du thread.
+     */
+    bool execute(I2C_priority priority, struct i2c_msg *msgs, uint32_t nmsgs);
+
+    // nombre de transactions en attente pour une classe
+    inline size_t queue_depth(I2C_priority priority) const { return queues[priority].size(); }
+
+    // fraction du temps passé dans les ioctl depuis start() (0 à 1)
+    float utilisation() const;
+
+    void print_stats() const;
+
+    /**
+     * Envoie nmsgs messages, par paquets de I2C_RDWR_IOCTL_MAX_MSGS messages par ioctl
+     * @return true si tous les messages ont été acquittés, false sinon avec errno modifié
+     */
+    static bool rdwr(int fd, struct i2c_msg *msgs, uint32_t nmsgs);
+
+    // Verrou d'arrêt d'urgence (posé depuis un gestionnaire de signal) : tant qu'il est
+    // posé, les transactions de classe I2C_PRIO_ACTUATION en file sont abandonnées
+    static volatile sig_atomic_t actuation_hold;
+
+    // Renvoi de la coupure préparée (PCA9685::arm_emergency_stop), appelé après une écriture
+    // I2C_PRIO_ACTUATION qui a croisé le verrou : la coupure reste la dernière écriture du bus
+    static bool (*emergency_resend)();
+
+private:
+    struct Transaction
+    {
+        struct i2c_msg *msgs = nullptr;
+        uint32_t nmsgs = 0;
+        std::promise<bool> done;
+        std::function<void(bool)> callback;
+    };
+
+    // profondeur max de chaque file
+    static constexpr size_t QUEUE_SIZE = 64;
+
+    int fd;
+    std::thread worker;
+    std::atomic<std::thread::id> worker_id{}; // id du thread, fixé par start(), vide une fois arrêté
+    std::atomic<bool> stopping{false};
+    sem_t pending; // nombre de transactions déposées et pas encore prises par le thread
+    // un ioctl à la fois sur le bus, que la transaction vienne du thread ou d'un appel direct
+    // (executor arrêté ou en cours d'arrêt/démarrage pendant l'appel)
+    std::mutex bus_mutex;
+
+    LockFreeQueue<Transaction, QUEUE_SIZE> queues[I2C_PRIO_COUNT];
+
+    // statistiques
+    std::atomic<uint64_t> busy_ns{0};
+    uint64_t start_ns = 0;
+    std::atomic<uint32_t> completed[I2C_PRIO_COUNT] = {};
+    std::atomic<uint32_t> failed[I2C_PRIO_COUNT] = {};
+    std::atomic<uint32_t> max_depth[I2C_PRIO_COUNT] = {};
+
+    bool enqueue(I2C_priority priority, Transaction &&t);
+    // rdwr() sous bus_mutex, puis emergency_resend si une commande moteur est partie verrou posé
+    bool write(I2C_priority priority, struct i2c_msg *msgs, uint32_t nmsgs);
+    void loop();
+    // termine en échec toutes les transactions encore en file
+    void fail_pending();
+};
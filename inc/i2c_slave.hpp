@@ -10,42 +10,85 @@
 #include <fcntl.h>
 #include <cstring>
 #include <cerrno>
+#include "i2c_bus.hpp"
 
-// spécifique au raspberry pi
-#define I2C_DEVICE "/dev/i2c-1"
+// Écriture d'un registre 8 bits, élément des séquences d'initialisation
+struct RegWrite
+{
+    uint8_t reg;
+    uint8_t value;
+};
+static_assert(sizeof(RegWrite) == 2, "RegWrite doit correspondre au buffer d'un message i2c");
+
+/**
+ * Séquence d'écritures compilée (voir compile_sequence) : les écritures à des registres
+ * consécutifs sont fusionnées en un seul message (auto-incrément), et tous les messages
+ * partent dans le moins d'ioctl I2C_RDWR possible.
+ * bytes contient les messages bout à bout (registre puis valeurs), offset/len les délimitent.
+ */
+template <size_t N>
+struct RegSequence
+{
+    uint8_t bytes[2 * N];
+    uint16_t offset[N];
+    uint16_t len[N];
+    uint32_t nmsgs;
+
+    // nombre d'ioctl nécessaires pour envoyer la séquence
+    constexpr uint32_t batches() const { return (nmsgs + I2C_RDWR_IOCTL_MAX_MSGS - 1) / I2C_RDWR_IOCTL_MAX_MSGS; }
+};
+
+/**
+ * Regroupe à la compilation une table d'écritures en messages I2C.
+ * Deux écritures successives sont fusionnées si la seconde vise le registre suivant
+ * (pas de fusion après 0xFF, qui sert de sélection de page sur le VL53L0X).
+ */
+template <size_t N>
+constexpr RegSequence<N> compile_sequence(const RegWrite (&seq)[N])
+{
+    RegSequence<N> out{};
+    uint16_t pos = 0;
+    for (size_t i = 0; i < N; i++)
+    {
+        bool merge = out.nmsgs > 0 && seq[i - 1].reg != 0xFF && seq[i].reg == seq[i - 1].reg + 1;
+        if (!merge)
+        {
+            out.offset[out.nmsgs] = pos;
+            out.len[out.nmsgs] = 1;
+            out.bytes[pos++] = seq[i].reg;
+            out.nmsgs++;
+        }
+        out.bytes[pos++] = seq[i].value;
+        out.len[out.nmsgs - 1]++;
+    }
+    return out;
+}
 
 class I2C_slave
 {
 private:
-    // variable faisant référence au descripteur de fichier du bus i2c, mis par défaut à -1 pour signalé que le bus n'est pas pret
-    // c'est grace a cette variable que le programme peut, au travers d'appels systèmes, communiquer sur le bus i2c
-    static int fd;
-
-    // booléen indiquant si le programme peut communiquer sur le bus i2c
-    static bool dev_initialized;
-    // Compteur d'instance
-    static uint8_t dev_ctn;
+    // bus sur lequel se trouve le périphérique, c'est au travers de son descripteur de fichier
+    // que le programme peut, par des appels systèmes, communiquer sur le bus i2c
+    I2C_bus *bus;
     // addresse i2c d'une instance
     uint8_t addr;
     // status of last I2C transmissions
     uint8_t last_status;
+    // classe de priorité des transactions de l'instance
+    I2C_priority priority;
 
 public:
-    /* */
-    I2C_slave(uint8_t addr);
+    /* bus_path : bus du périphérique, ouvert à la première instance qui l'utilise */
+    I2C_slave(uint8_t addr, I2C_priority priority = I2C_PRIO_DIAGNOSTIC, const char *bus_path = I2C_DEVICE);
+    I2C_slave(I2C_slave const &other);
+    I2C_slave &operator=(I2C_slave const &other);
     ~I2C_slave();
 
-    /**
-     * Initialise le bus I2C
-     * @return true si la méthode a ouvert le bus (file descriptor valide), ou false quand il y a une erreur avec errno indiquant l'erreur
-     */
-    static bool bus_open();
+    // bus du périphérique
+    inline I2C_bus *get_bus() const { return bus; }
 
-    /**
-     * Ferme le bus I2C
-     * @return true si le bus est fermé, false sinon avec errno indique le status
-     */
-    static bool bus_close();
+    // addresse i2c de l'instance
+    inline uint8_t get_address() const { return addr; }
 
     /**
      * Modifie un registre a l'addresse reg par la valeur value
@@ -62,6 +105,29 @@ public:
     bool write(uint8_t reg, uint16_t *data, uint32_t sdata);
     bool write(uint8_t reg, uint32_t *data, uint32_t sdata);
 
+    /**
+     * Écrit une suite de registres, un message par registre, regroupés en un minimum d'ioctl
+     * @return true si tous les messages ont été acquittés
+     */
+    bool write(RegWrite const *seq, uint32_t count);
+
+    /**
+     * Écrit une séquence compilée par compile_sequence
+     */
+    template <size_t N>
+    bool write(RegSequence<N> const &seq)
+    {
+        struct i2c_msg msgs[N];
+        for (uint32_t i = 0; i < seq.nmsgs; i++)
+        {
+            msgs[i].addr = addr;
+            msgs[i].flags = 0;
+            msgs[i].len = seq.len[i];
+            msgs[i].buf = const_cast<uint8_t *>(&seq.bytes[seq.offset[i]]);
+        }
+        return transfer(msgs, seq.nmsgs);
+    }
+
     /**
      * Lit la valeur (sur un octet) d'un registre à l'addresse reg.
      * @attention la methode ne peut pas determiner la taille réelle de la valeur du registre (à determiner dans les datasheet). Si la taille ne correspond pas, comportement inattendu.
@@ -77,4 +143,13 @@ public:
     bool read(uint8_t reg, uint8_t *data, uint32_t sdata);
     bool read(uint8_t reg, uint16_t *data, uint32_t sdata);
     bool read(uint8_t reg, uint32_t *data, uint32_t sdata);
+
+protected:
+    /**
+     * Envoie nmsgs messages, par paquets de I2C_RDWR_IOCTL_MAX_MSGS messages par ioctl.
+     * Si l'executor tourne, la transaction passe par sa file de priorité.
+     * @return true si tous les messages ont été acquittés, false sinon avec errno modifié
+     */
+    bool transfer(struct i2c_msg *msgs, uint32_t nmsgs) { return transfer(msgs, nmsgs, priority); }
+    bool transfer(struct i2c_msg *msgs, uint32_t nmsgs, I2C_priority priority) { return bus->transfer(msgs, nmsgs, priority); }
 };
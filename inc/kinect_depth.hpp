@@ -0,0 +1,64 @@
+#pragma once
+#include <cstdint>
+
+/*
+    Conversion de la disparité brute 11 bits de la Kinect en millimètres.
+    Formule d'étalonnage d'OpenKinect : profondeur (m) = 1 / (raw * -0.0030711016 + 3.3309495161)
+    valable pour raw < 1084 ; 2047 signifie "pas de donnée".
+    La table est calculée à la compilation, la conversion ne coûte qu'une lecture :
+    on agrège les pixels en disparité et on ne convertit que les résultats par zone.
+*/
+
+// Nombre de valeurs possibles sur 11 bits
+constexpr uint16_t DISPARITY_VALUES = 2048;
+// Code "pas de donnée" (trop proche, trop loin, ombre)
+constexpr uint16_t DISPARITY_NO_VALUE = 2047;
+
+struct DepthLut
+{
+    uint16_t mm[DISPARITY_VALUES];
+};
+
+constexpr DepthLut make_depth_lut()
+{
+    DepthLut lut{};
+    for (uint16_t raw = 0; raw < DISPARITY_VALUES; raw++)
+    {
+        double denom = raw * -0.0030711016 + 3.3309495161;
+        // hors de la plage de l'étalonnage : pas de donnée
+        lut.mm[raw] = (raw == DISPARITY_NO_VALUE || denom <= 0.1) ? 0 : (uint16_t)(1000.0 / denom + 0.5);
+    }
+    return lut;
+}
+
+inline constexpr DepthLut DEPTH_LUT = make_depth_lut();
+
+// Disparité brute -> mm (0 si pas de donnée)
+constexpr uint16_t disparity_to_mm(uint16_t raw)
+{
+    return DEPTH_LUT.mm[raw & (DISPARITY_VALUES - 1)];
+}
+
+// Disparité moyenne (non entière) -> mm, interpolation linéaire entre deux entrées de la table
+constexpr float mean_disparity_to_mm(float raw)
+{
+    if (raw <= 0)
+        return DEPTH_LUT.mm[0];
+    uint16_t i = (uint16_t)raw;
+    if (i >= DISPARITY_NO_VALUE - 1)
+        return 0;
+    float t = raw - i;
+    return DEPTH_LUT.mm[i] + t * (DEPTH_LUT.mm[i + 1] - DEPTH_LUT.mm[i]);
+}
+
+// Plus petite disparité dont la profondeur dépasse mm (la profondeur croît avec la disparité)
+constexpr uint16_t mm_to_disparity(uint16_t mm)
+{
+    uint16_t raw = 0;
+    while (raw < DISPARITY_NO_VALUE && DEPTH_LUT.mm[raw] != 0 && DEPTH_LUT.mm[raw] < mm)
+        raw++;
+    return raw;
+}
+
+static_assert(disparity_to_mm((uint16_t)DISPARITY_NO_VALUE) == 0, "2047 doit rester 'pas de donnée'");
+static_assert(mm_to_disparity(900) > 0 && disparity_to_mm(mm_to_disparity(900)) >= 900, "table non monotone");
@@ -0,0 +1,40 @@
+#pragma once
+#include <atomic>
+#include <cstdint>
+
+/*
+    Mailbox template
+    Boîte aux lettres sans verrou entre un producteur et un consommateur : seule la
+    dernière valeur publiée compte. Triple tampon : le producteur écrit dans son
+    tampon puis l'échange avec le tampon du milieu, le consommateur récupère le
+    tampon du milieu s'il est marqué frais. Aucun des deux n'attend jamais l'autre.
+*/
+template <typename T>
+class Mailbox
+{
+public:
+    // Appelé par le seul producteur
+    void publish(T const &value)
+    {
+        buffers[back] = value;
+        back = middle.exchange(back | FRESH) & INDEX;
+    }
+
+    // Appelé par le seul consommateur : false si rien de nouveau depuis le dernier fetch
+    bool fetch(T &value)
+    {
+        if (!(middle.load() & FRESH))
+            return false;
+        front = middle.exchange(front) & INDEX;
+        value = buffers[front];
+        return true;
+    }
+
+private:
+    static constexpr uint8_t INDEX = 0x03, FRESH = 0x04;
+
+    T buffers[3];
+    uint8_t back = 0;  // tampon du producteur
+    uint8_t front = 1; // tampon du consommateur
+    std::atomic<uint8_t> middle{2};
+};
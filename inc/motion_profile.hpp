@@ -0,0 +1,46 @@
+#pragma once
+#include <cstdint>
+
+// Changement de commande : à t_us depuis le début du profil, rapport cyclique signé
+struct ProfileStep
+{
+    uint32_t t_us;
+    int16_t duty;
+};
+
+/*
+    TrapezoidProfile class
+    Profil de vitesse trapézoïdal d'un moteur, discrétisé en paliers de rapport
+    cyclique : levels paliers également espacés entre duty_min (plus faible commande
+    qui fait tourner le moteur) et duty_max, chacun tenu le temps de passer au suivant
+    à l'accélération demandée. La vitesse est supposée proportionnelle au rapport
+    cyclique (speed_per_duty mm/s par unité). Le profil n'est qu'une liste de points
+    de changement : le PCA9685 n'est écrit qu'à ces instants.
+*/
+class TrapezoidProfile
+{
+public:
+    static constexpr int MAX_LEVELS = 8;
+    static constexpr int MAX_STEPS = 2 * (MAX_LEVELS + 1) + 1;
+
+    /**
+     * Planifie un déplacement
+     * @param distance mm, signée
+     * @param start_duty commande en cours : un moteur déjà lancé dans le même sens repart de son palier
+     */
+    void plan(float distance, int16_t start_duty, float accel, uint16_t duty_min, uint16_t duty_max,
+              float speed_per_duty, int levels);
+
+    // Commande à appliquer t_us après le début du profil
+    int16_t duty_at(uint32_t t_us) const;
+
+    inline uint32_t duration_us() const { return count ? steps[count - 1].t_us : 0; }
+    inline bool finished(uint32_t t_us) const { return t_us >= duration_us(); }
+    inline int step_count() const { return count; }
+
+private:
+    ProfileStep steps[MAX_STEPS];
+    uint8_t count = 0;
+
+    void add(float t_s, int16_t duty);
+};
@@ -0,0 +1,14 @@
+#pragma once
+
+// Matrice de pins et moteurs, partagés par la boucle principale et les scénarios de test
+#define COLS 2
+#define ROWS 2
+#define TOTAL_MOTORS (COLS * ROWS)
+
+// vitesse à VMAX tant que le moteur n'est pas calibré (SPEED_MODEL_FILE)
+const float VITESSE_MM_S = 14.0;
+const float COURSE_MAX = 70.0;
+const int VMAX = 4095;
+const int VOFF = 0;
+// plus faible commande qui fait tourner un moteur, début des courbes de vitesse
+const int VMOY = 2500;
@@ -1,12 +1,13 @@
 #pragma once
 
 #include "i2c_slave.hpp"
+#include <ctime>
 
 class PCA9685 : public I2C_slave
 {
 public:
     // Constructor
-    PCA9685(uint8_t address = 0x40);
+    PCA9685(uint8_t address = 0x40, const char *bus_path = I2C_DEVICE);
 
     // Destructor
     ~PCA9685() = default;
@@ -17,31 +18,99 @@ public:
     // Set PWM frequency in Hz
     bool set_frequency(uint16_t frequency);
 
+    // Set PWM frequency in Hz without reading MODE1 (mode1 : current MODE1 value),
+    // usable on the ALL_CALL address where nobody answers reads
+    bool set_frequency(uint16_t frequency, uint8_t mode1);
+
+    // Program the ALL_CALL address the board answers to (7 bits)
+    bool set_all_call_address(uint8_t address);
+
     // Set on/off cycle for a specific channel (0-15)
     bool set_time(uint8_t channel, uint16_t on_time, uint16_t off_time);
 
     // Set on/off cycle for all channels
     bool set_time_burst(uint16_t *on_time, uint16_t *off_time);
 
+    // Encode on/off times of one channel into its 4 LEDn registers (same rules as set_time)
+    static void encode_time(uint8_t *dst, uint16_t on_time, uint16_t off_time);
+
+    // Encode a duty cycle (same rules as set_pwm)
+    static void encode_pwm(uint8_t *dst, uint16_t duty);
+
+    // Encode a duty cycle whose on-time starts at phase (0-MAX_PWM) instead of 0,
+    // the pulse wraps around the end of the period if needed
+    static void encode_pwm(uint8_t *dst, uint16_t duty, uint16_t phase);
+
     // Set PWM duty cycle as percentage (0-MAX_PWM)
     bool set_pwm(uint8_t channel, uint16_t duty);
 
     // Reset the device
     bool reset();
 
+    // Turn every channel fully off in one write (ALL_LED registers),
+    // sent in the emergency class of the bus executor by default
+    bool all_off(I2C_priority priority = I2C_PRIO_EMERGENCY);
+
+    // Arme l'arrêt d'urgence sur cette carte (ou sur l'adresse ALL_CALL pour toutes les cartes)
+    void arm_emergency_stop() const;
+
+    /**
+     * Coupe toutes les sorties de la cible armée par arm_emergency_stop().
+     * Utilisable depuis un gestionnaire de signal : un seul ioctl sur un message
+     * préparé à l'avance, sans verrou, sans allocation et sans passer par l'executor.
+     * Pose le verrou d'urgence, même si rien n'est armé : plus aucune commande moteur
+     * ne part (PwmBank::flush, file actionneurs de l'executor) jusqu'à clear_emergency().
+     * @return false si rien n'est armé ou si l'écriture a échoué
+     */
+    static bool emergency_stop();
+
+    // Verrou d'urgence posé par emergency_stop()
+    static inline bool emergency_latched() { return I2C_executor::actuation_hold; }
+
+    // Lève le verrou : seulement après avoir coupé les sorties (PwmBank::all_stop) ou pour un retour en position demandé
+    static inline void clear_emergency() { I2C_executor::actuation_hold = 0; }
+
+    // Durée entre l'appel de emergency_stop() et l'acquittement des cartes, en µs (-1 si jamais appelé)
+    static long emergency_latency_us();
+
     static constexpr uint16_t MAX_PWM = 4095;
-private:
-    // config bits
-    static constexpr uint8_t SLEEP = 0b00010000;
-    static constexpr uint8_t RESTART = 0b10000000;
+    static constexpr uint8_t CHANNELS = 16;
+
+    // MODE1 after init(): auto-increment, answers to ALL_CALL
+    static constexpr uint8_t MODE1_DEFAULT = 0x21;
+
+    // Default ALL_CALL address (power-on value of ALLCALLADR)
+    // /!\ same address as a TCA9548A with A0-A2 low on the same bus
+    static constexpr uint8_t ALL_CALL_ADDRESS = 0x70;
 
     // PCA9685 register addresses
     static constexpr uint8_t MODE1 = 0x00;
     static constexpr uint8_t MODE2 = 0x01;
+    static constexpr uint8_t ALLCALLADR = 0x05;
 
     static constexpr uint8_t LED0_ON_L = 0x06;
     static constexpr uint8_t LED0_ON_H = 0x07;
     static constexpr uint8_t LED0_OFF_L = 0x08;
     static constexpr uint8_t LED0_OFF_H = 0x09;
+    static constexpr uint8_t ALL_LED_ON_L = 0xFA;
+    static constexpr uint8_t ALL_LED_ON_H = 0xFB;
+    static constexpr uint8_t ALL_LED_OFF_L = 0xFC;
+    static constexpr uint8_t ALL_LED_OFF_H = 0xFD;
     static constexpr uint8_t PRE_SCALE = 0xFE;
+
+    // bit "full OFF" de LEDn_OFF_H / ALL_LED_OFF_H
+    static constexpr uint8_t FULL_OFF = 0x10;
+
+private:
+    // config bits
+    static constexpr uint8_t SLEEP = 0b00010000;
+    static constexpr uint8_t RESTART = 0b10000000;
+
+    // arrêt d'urgence : message préparé par arm_emergency_stop()
+    static int emergency_fd;
+    static uint8_t emergency_buf[5];
+    static struct i2c_msg emergency_msg;
+    static struct timespec emergency_start, emergency_end;
+    // renvoi du message préparé, sans toucher au verrou ni aux mesures de latence
+    static bool resend_emergency();
 };
\ No newline at end of file
@@ -0,0 +1,80 @@
+#pragma once
+#include <cstdint>
+#include <vector>
+#include "depth_frame.hpp"
+#include "zone_stats.hpp"
+
+// Fichier des points de calibration grille de pins -> pixels de profondeur
+#define PIN_MAPPING_FILE "pin_mapping.txt"
+
+// Correspondance entre un point de la grille (unité : un pin) et un pixel de la trame
+struct PinPoint
+{
+    float grid_x, grid_y;
+    float pixel_x, pixel_y;
+};
+
+/*
+    Homography class
+    Transformation projective du plan (matrice 3x3, h[8] = 1), ajustée aux moindres
+    carrés sur des correspondances de points. Couvre l'inclinaison et le décentrage
+    de la Kinect par rapport au plan des pins.
+*/
+class Homography
+{
+public:
+    Homography();
+
+    // Ajuste sur au moins 4 correspondances grille -> pixel, false si dégénéré
+    bool fit(std::vector<PinPoint> const &points);
+    void apply(float x, float y, float &u, float &v) const;
+    Homography inverse() const;
+
+private:
+    double h[9];
+};
+
+/*
+    PinMapping class
+    Relie chaque pin de la grille cols x rows aux pixels de profondeur qui le voient.
+    Le pin (c, r) occupe la cellule [c, c+1] x [r, r+1] de la grille ; seule la partie
+    centrale de footprint_w x footprint_h (fractions de la cellule) est échantillonnée.
+    build() précalcule une fois pour chaque pin ses pixels dans le buffer compact de la
+    trame : segments de ligne contigus sans pondération, ou offsets et poids en tente
+    (centre du pin privilégié) ; chaque trame ne fait plus qu'un parcours de la table.
+*/
+class PinMapping
+{
+public:
+    // Disposition par défaut : la grille couvre le rectangle [0, width] x [0, height] de l'image
+    PinMapping(int cols, int rows, float footprint_w, float footprint_h, float width, float height);
+
+    // Charge les correspondances de path et ajuste l'homographie, false si absent ou invalide
+    bool load(const char *path);
+    // Écrit les correspondances courantes, modèle à corriger pour une nouvelle installation
+    bool save(const char *path) const;
+
+    // Boîte englobante des pixels du pin dans l'image
+    Rect bounds(int pin) const;
+
+    // Précalcule les tables de pixels de tous les pins, offsets dans le buffer de frame
+    // weighted : poids en tente, sinon tous les pixels comptent autant (parcours vectorisé)
+    void build(DepthFrame const &frame, bool weighted);
+    inline PixelTable const &pixels(int pin) const { return tables[pin]; }
+
+    // count pixels du pin tirés selon la suite R2 dans la cellule, triés pour l'accès mémoire
+    SamplePattern sample(DepthFrame const &frame, int pin, int count) const;
+
+    // Erreur quadratique moyenne de l'ajustement sur les points de calibration, en pixels
+    inline float get_error() const { return rms_error; }
+
+private:
+    int cols, rows;
+    float footprint_w, footprint_h;
+    std::vector<PinPoint> points;
+    Homography grid_to_image, image_to_grid;
+    float rms_error = 0;
+    std::vector<PixelTable> tables;
+
+    bool fit(std::vector<PinPoint> const &calibration);
+};
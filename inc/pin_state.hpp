@@ -0,0 +1,75 @@
+#pragma once
+#include <cstdint>
+#include <cstddef>
+
+// dernières positions connues des pins, relues au démarrage
+#define PIN_STATE_FILE "pin_state.bin"
+
+/*
+    PinStateStore class
+    Positions estimées des pins dans un petit fichier projeté en mémoire (mmap) : une
+    sauvegarde n'est qu'une copie en mémoire, le noyau l'écrit sur disque. Deux
+    emplacements alternés, chacun avec un numéro de séquence et une somme de contrôle :
+    une sauvegarde interrompue ne corrompt que l'emplacement en cours d'écriture, la
+    relecture prend le plus récent des emplacements valides.
+    clean n'est vrai que pour la sauvegarde d'un arrêt normal, moteurs coupés : au
+    démarrage suivant les positions sont fiables. Après un plantage ou une coupure
+    de courant, elles ne sont qu'une estimation (les moteurs ont pu tourner ensuite).
+*/
+class PinStateStore
+{
+public:
+    explicit PinStateStore(int motors);
+    ~PinStateStore();
+
+    PinStateStore(PinStateStore const &) = delete;
+    PinStateStore &operator=(PinStateStore const &) = delete;
+
+    /**
+     * Ouvre ou crée le fichier et le projette en mémoire
+     * @return false si le fichier est inutilisable (les sauvegardes sont alors ignorées)
+     */
+    bool open(const char *path);
+
+    /**
+     * Relit la dernière sauvegarde valide
+     * @param positions reçoit une position par moteur
+     * @param trusted vrai si la sauvegarde vient d'un arrêt normal
+     * @return false si aucune sauvegarde valide pour ce nombre de moteurs
+     */
+    bool resume(float *positions, bool &trusted) const;
+
+    /**
+     * Enregistre les positions dans l'emplacement le plus ancien
+     * @param clean vrai seulement à l'arrêt, moteurs coupés
+     * @param sync attend l'écriture sur disque (msync synchrone) au lieu de la lancer
+     */
+    void checkpoint(float const *positions, bool clean, bool sync = false);
+
+    inline uint64_t get_checkpoints() const { return checkpoints; }
+
+private:
+    static constexpr uint32_t MAGIC = 0x50494E53; // "PINS"
+
+    struct Slot
+    {
+        uint32_t magic;
+        uint32_t checksum; // FNV-1a de tout l'emplacement après ce champ
+        uint32_t sequence;
+        uint16_t motors;
+        uint8_t clean;
+        uint8_t reserved;
+        float positions[]; // motors positions
+    };
+
+    int motors;
+    int fd = -1;
+    uint8_t *map = nullptr;
+    size_t slot_size, map_size;
+    uint32_t sequence = 0;
+    uint64_t checkpoints = 0;
+
+    inline Slot *slot(int k) const { return reinterpret_cast<Slot *>(map + k * slot_size); }
+    uint32_t checksum(Slot const *s) const;
+    bool valid(Slot const *s) const;
+};
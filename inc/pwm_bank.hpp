@@ -0,0 +1,91 @@
+#pragma once
+
+#include <atomic>
+#include <vector>
+#include "pca9685.hpp"
+
+/*
+    PwmBank class
+    Plusieurs PCA9685 à des adresses consécutives vues comme une seule banque de
+    moteurs : chaque moteur utilise deux canaux (sens A / sens B), soit 8 moteurs
+    par carte. Le moteur m est sur la carte m / 8, canaux 2 * (m % 8) et 2 * (m % 8) + 1.
+    Les commandes sont préparées en mémoire puis envoyées par flush() : une trame
+    de 16 canaux par carte modifiée, toutes les trames dans une même transaction.
+    Les impulsions des moteurs d'une carte sont décalées de 1/8 de période.
+*/
+class PwmBank
+{
+public:
+    static constexpr uint8_t MOTORS_PER_BOARD = PCA9685::CHANNELS / 2;
+
+    PwmBank(uint8_t nb_boards, uint8_t first_address = 0x40, const char *bus_path = I2C_DEVICE,
+            uint8_t all_call_address = PCA9685::ALL_CALL_ADDRESS);
+    ~PwmBank();
+
+    PwmBank(PwmBank const &) = delete;
+    PwmBank &operator=(PwmBank const &) = delete;
+
+    /**
+     * Initialise chaque carte (reset, modes, adresse ALL_CALL) puis règle la fréquence
+     * de toutes les cartes en une fois via l'adresse ALL_CALL
+     * @return true si toutes les cartes répondent
+     */
+    bool init(uint16_t frequency = 50);
+
+    // nombre de moteurs pilotables
+    inline uint16_t motors() const { return boards.size() * MOTORS_PER_BOARD; }
+
+    /**
+     * Prépare la commande d'un moteur (envoyée au prochain flush())
+     * @param duty_a rapport cyclique du canal A (0-MAX_PWM)
+     * @param duty_b rapport cyclique du canal B (0-MAX_PWM)
+     */
+    void set_motor(uint16_t motor, uint16_t duty_a, uint16_t duty_b);
+
+    // Prépare l'arrêt d'un moteur
+    inline void stop_motor(uint16_t motor) { set_motor(motor, 0, 0); }
+
+    /**
+     * Envoie la trame de chaque carte modifiée depuis le dernier flush(),
+     * les cartes à la suite dans une même transaction i2c
+     * N'envoie rien tant que le verrou d'arrêt d'urgence est posé
+     * @return true si toutes les cartes ont acquitté
+     */
+    bool flush();
+
+    /**
+     * Coupe toutes les sorties de toutes les cartes en une écriture de 4 octets
+     * (registres ALL_LED) sur l'adresse ALL_CALL, puis lève le verrou d'arrêt d'urgence
+     * @return true si succès
+     */
+    bool all_stop();
+
+    /**
+     * Coupe toutes les sorties depuis un autre thread (watchdog) sans toucher aux trames
+     * en mémoire ; le prochain flush() renverra toutes les cartes
+     * @return true si succès
+     */
+    bool force_stop();
+
+    // transactions envoyées par flush() depuis le démarrage
+    inline uint64_t get_transactions() const { return transactions; }
+
+private:
+    // taille d'une trame : registre de départ + 4 registres par canal
+    static constexpr uint8_t FRAME_SIZE = 1 + 4 * PCA9685::CHANNELS;
+
+    struct Board
+    {
+        PCA9685 *pca;
+        uint8_t frame[FRAME_SIZE]; // LED0_ON_L suivi des registres des 16 canaux
+        bool dirty;
+    };
+
+    std::vector<Board> boards;
+    // écritures simultanées sur toutes les cartes (pas de lecture possible)
+    PCA9685 all_call;
+    uint8_t all_call_address;
+    // sorties coupées par force_stop() : les trames en mémoire ne reflètent plus les cartes
+    std::atomic<bool> outputs_lost{false};
+    uint64_t transactions = 0;
+};
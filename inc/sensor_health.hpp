@@ -0,0 +1,96 @@
+#pragma once
+#include <atomic>
+#include <condition_variable>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+// Résultat d'une interrogation d'un capteur
+enum SensorResult
+{
+    SENSOR_PENDING, // pas de mesure prête
+    SENSOR_VALID,   // mesure d'état valide
+    SENSOR_INVALID, // mesure reçue avec un état d'erreur (signal trop faible, phase...)
+    SENSOR_ERROR,   // échec du bus i2c
+};
+
+// Seuils de mise en quarantaine
+struct SensorHealthConfig
+{
+    uint32_t timeout_us;   // sans mesure pendant ce délai : un timeout
+    float max_timeout_rate; // proportion (moyenne glissante) d'interrogations en timeout
+    float max_invalid_rate; // proportion de mesures invalides
+    int stuck_count;        // mesures identiques successives, moteur en mouvement
+    int min_events;         // événements avant de juger les proportions
+    uint32_t retry_ms;      // délai avant une nouvelle tentative de reprise, doublé à chaque échec
+    uint32_t max_retry_ms;
+};
+
+/*
+    SensorHealth class
+    Suit la santé de chaque capteur à partir des interrogations de la boucle de commande :
+    proportion de timeouts et de mesures invalides (moyennes glissantes) et valeurs figées
+    (même distance répétée alors que le moteur tourne). Un capteur hors seuils est mis en
+    quarantaine : la boucle ne l'interroge plus et se contente de l'estimation de position,
+    pendant qu'un thread à part le réinitialise (recover), sans bloquer la boucle. En cas
+    d'échec la reprise est retentée avec un délai croissant.
+*/
+class SensorHealth
+{
+public:
+    SensorHealth(int sensors, SensorHealthConfig const &config);
+    ~SensorHealth();
+
+    SensorHealth(SensorHealth const &) = delete;
+    SensorHealth &operator=(SensorHealth const &) = delete;
+
+    // recover(capteur) réinitialise le capteur, appelé par le thread de reprise
+    void start(std::function<bool(int)> recover);
+    void stop();
+
+    /**
+     * Enregistre une interrogation (thread de la boucle de commande)
+     * @param moving le moteur du capteur est commandé : une distance figée est suspecte
+     */
+    void record(int sensor, uint64_t t_us, SensorResult result, uint16_t range = 0, bool moving = false);
+
+    // capteur utilisable par la boucle (hors quarantaine)
+    inline bool usable(int sensor) const { return !slots[sensor].quarantined; }
+
+    inline uint32_t get_quarantines(int sensor) const { return slots[sensor].quarantines; }
+    inline uint32_t get_recoveries(int sensor) const { return slots[sensor].recoveries; }
+
+    void print_stats() const;
+
+private:
+    struct Slot
+    {
+        std::atomic<bool> quarantined{false};
+        std::atomic<uint32_t> quarantines{0}, recoveries{0};
+        // boucle de commande seulement
+        float timeout_rate = 0, invalid_rate = 0;
+        int events = 0;
+        uint64_t last_reading_us = 0;
+        uint16_t last_range = 0;
+        int repeats = 0;
+        const char *reason = "";
+    };
+
+    int sensors;
+    SensorHealthConfig config;
+    std::unique_ptr<Slot[]> slots;
+
+    std::function<bool(int)> recover;
+    std::thread worker;
+    std::mutex mutex;
+    std::condition_variable wake;
+    std::vector<int> pending; // capteurs en attente de reprise (protégé par mutex)
+    bool running = false;
+
+    void quarantine(int sensor, const char *reason);
+    void clear(Slot &slot);
+    void loop();
+};
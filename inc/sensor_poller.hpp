@@ -0,0 +1,59 @@
+#pragma once
+#include <cstdint>
+#include <vector>
+
+// État du moteur d'un capteur, qui fixe l'intervalle entre deux lectures
+enum SensorActivity
+{
+    SENSOR_MOVING,   // moteur commandé : lecture à chaque mesure du capteur
+    SENSOR_SETTLING, // arrêté depuis peu : le pin peut encore glisser
+    SENSOR_IDLE,     // à l'arrêt : simple contrôle de dérive
+    SENSOR_NONE,     // pas de capteur
+};
+
+/*
+    SensorPoller class
+    Choisit à chaque tick les capteurs à interroger. Un capteur est dû quand l'intervalle
+    de son activité est écoulé depuis sa dernière mesure (pas sa dernière interrogation :
+    une mesure pas encore prête est redemandée au tick suivant). Les capteurs dus sont
+    servis du plus en retard (rapporté à son intervalle) au moins en retard, tant que la
+    somme de leurs coûts i2c estimés tient dans le budget du tick ; les autres attendent
+    le tick suivant, plus en retard donc prioritaires.
+*/
+class SensorPoller
+{
+public:
+    /**
+     * @param interval_us intervalle entre deux mesures pour SENSOR_MOVING, SENSOR_SETTLING, SENSOR_IDLE
+     * @param budget_us temps i2c maximal par tick (le capteur le plus en retard est toujours servi)
+     */
+    SensorPoller(int sensors, uint32_t const interval_us[3], uint32_t budget_us);
+
+    /**
+     * Capteurs à interroger ce tick
+     * @param order reçoit les indices, du plus prioritaire au moins prioritaire
+     * @return nombre de capteurs à interroger
+     */
+    int schedule(uint64_t t_us, SensorActivity const *activity, int *order);
+
+    /**
+     * Résultat d'une interrogation
+     * @param cost_us durée de l'échange i2c
+     * @param measured une mesure était prête
+     */
+    void done(int sensor, uint64_t t_us, uint32_t cost_us, bool measured);
+
+    inline uint64_t get_polls() const { return polls; }
+    inline uint64_t get_readings() const { return readings; }
+    // capteurs dus reportés faute de budget
+    inline uint64_t get_deferred() const { return deferred; }
+
+private:
+    int sensors;
+    uint32_t interval_us[3];
+    uint32_t budget_us;
+    std::vector<uint64_t> last_us; // dernière mesure de chaque capteur
+    std::vector<float> cost_us;    // coût moyen d'une interrogation
+    std::vector<float> lateness;
+    uint64_t polls = 0, readings = 0, deferred = 0;
+};
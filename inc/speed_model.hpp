@@ -0,0 +1,71 @@
+#pragma once
+#include <cstdint>
+#include <vector>
+
+// courbes vitesse / rapport cyclique apprises, relues au démarrage
+#define SPEED_MODEL_FILE "speed_model.txt"
+
+/*
+    SpeedModel class
+    Vitesse de chaque moteur dans chaque sens en fonction du rapport cyclique : POINTS
+    vitesses (mm/s) à des rapports cycliques également espacés de duty_min à duty_max,
+    interpolées linéairement entre deux points et vers 0 sous duty_min. Sans calibration
+    la courbe est la droite de la vitesse nominale. Chaque mesure (vitesse observée à
+    une commande tenue) corrige les deux points qui l'encadrent au prorata de leur poids.
+*/
+class SpeedModel
+{
+public:
+    static constexpr int POINTS = 5;
+
+    // default_speed : vitesse à duty_max, dans les deux sens
+    SpeedModel(int motors, uint16_t duty_min, uint16_t duty_max, float default_speed);
+
+    /**
+     * Vitesse attendue d'un moteur
+     * @param duty commande signée
+     * @return mm/s, du signe de la commande
+     */
+    float speed(int motor, int16_t duty) const;
+
+    /**
+     * Corrige la courbe avec une vitesse mesurée
+     * @param duty commande signée tenue pendant la mesure (ignorée sous duty_min)
+     * @param measured vitesse mesurée, mm/s signée
+     * @param gain part de l'écart corrigée (1 : le point prend la mesure)
+     */
+    void observe(int motor, int16_t duty, float measured, float gain);
+
+    // Fichier texte : "duty d0 ... d4" (rapports cycliques des points des lignes suivantes), puis
+    // "moteur sens v0 ... v4" par ligne, sens + ou -, # pour les commentaires. Une courbe mesurée
+    // sur une autre grille est rééchantillonnée ; celles des moteurs au-delà de motors sont
+    // gardées telles quelles, avec leur grille, et réécrites par save().
+    bool load(const char *path);
+    bool save(const char *path) const;
+
+    // rapport cyclique du point k
+    inline uint16_t duty_point(int k) const { return duty_min + k * (duty_max - duty_min) / (POINTS - 1); }
+    // mesures prises en compte depuis le démarrage
+    inline uint64_t get_samples() const { return samples; }
+
+private:
+    int motors;
+    uint16_t duty_min, duty_max;
+    // [moteur][sens (0 : montée, 1 : descente)][point], vitesses positives
+    std::vector<float> curves;
+    uint64_t samples = 0;
+
+    // courbe lue pour un moteur hors de [0, motors)
+    struct ForeignCurve
+    {
+        int motor;
+        char sens;
+        int grid[POINTS];
+        float v[POINTS];
+    };
+    std::vector<ForeignCurve> foreign;
+
+    void segment(int d, int &k, float &w) const;
+    inline float *curve(int motor, int16_t duty) { return &curves[(2 * motor + (duty < 0)) * POINTS]; }
+    inline float const *curve(int motor, int16_t duty) const { return &curves[(2 * motor + (duty < 0)) * POINTS]; }
+};
@@ -0,0 +1,40 @@
+#pragma once
+#include <cstdint>
+#include <cstdio>
+#include <functional>
+#include <string>
+#include <thread>
+#include <vector>
+
+/*
+    Startup class
+    Lance en parallèle les étapes d'initialisation (Kinect, PCA9685, capteurs...)
+    et garde une trace de leurs durées pour afficher la chronologie du démarrage.
+    Les étapes qui partagent le bus i2c s'entrelacent transaction par transaction
+    (verrou dans I2C_slave), leurs attentes se recouvrent.
+*/
+class Startup
+{
+public:
+    // Ajoute une étape, exécutée dans son propre thread par run()
+    void add(std::string name, std::function<bool()> step);
+
+    // Lance toutes les étapes et attend leur fin
+    // @return true si toutes les étapes ont réussi
+    bool run();
+
+    // Affiche la chronologie de la dernière exécution
+    void print_timeline() const;
+
+private:
+    struct Step
+    {
+        std::string name;
+        std::function<bool()> fn;
+        uint32_t start_ms;
+        uint32_t end_ms;
+        bool ok;
+    };
+    std::vector<Step> steps;
+    uint32_t total_ms = 0;
+};
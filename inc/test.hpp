@@ -9,6 +9,8 @@
 #include <string>
 #include "pca9685.hpp"
 #include "vl53l0x.hpp"
+#include "speed_model.hpp"
+#include "motor_config.hpp"
 
 // Dimensions de la matrice de points pour le scénario MATRIX
 #define stX 12
@@ -40,12 +42,16 @@ enum ScenarioType
     SCENARIO_UNKNOWN = -1,
 };
 
+// Gestionnaire de SIGINT : arrêt d'urgence des moteurs puis demande d'arrêt (should_exit)
+void signal_handler(int signal);
+
 class Test
 {
 private:
     ScenarioType scenario;
     PCA9685 *pca9685;
     int scenario_calibrage();
+    void calibrate_speed(PCA9685 &pca, int motor);
     int scenario_matrix();
     int scenario_vl53l0x();
     int scenario_pca9685(uint8_t a = 0x40);
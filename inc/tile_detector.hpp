@@ -0,0 +1,57 @@
+#pragma once
+#include <cstdint>
+#include <vector>
+#include "depth_frame.hpp"
+
+/*
+    TileDetector class
+    Détection de changement grossière sur le buffer compact d'une DepthFrame :
+    chaque tuile de TILE x TILE pixels a une signature (moyenne, min, max) comparée
+    à celle de la trame précédente. Les pixels sont plafonnés à ceiling (seuil de
+    validité des zones) pour que les trous du capteur ne fassent pas clignoter le max.
+    Une tuile dont la moyenne bouge de plus de
+    mean_delta, ou le min/max de plus de range_delta, est marquée modifiée.
+    Les zones qui ne recouvrent aucune tuile modifiée n'ont pas à être recalculées.
+*/
+class TileDetector
+{
+public:
+    static constexpr int TILE = 16;
+
+    // seuils dans l'unité de la trame (disparité brute ou mm)
+    TileDetector(DepthFrame const &frame, uint16_t ceiling, uint16_t mean_delta, uint16_t range_delta);
+
+    // Calcule les signatures de la trame courante et marque les tuiles modifiées
+    void update();
+
+    // vrai si la fenêtre (coordonnées de l'image, dans le ROI) recouvre une tuile modifiée
+    bool changed(Rect const &window);
+
+    // Force le recalcul de toutes les tuiles à la prochaine trame
+    inline void invalidate() { primed = false; }
+
+    // compteurs cumulés depuis le démarrage
+    inline uint64_t get_tiles_checked() const { return tiles_checked; }
+    inline uint64_t get_tiles_dirty() const { return tiles_dirty; }
+    inline uint64_t get_zones_checked() const { return zones_checked; }
+    inline uint64_t get_zones_skipped() const { return zones_skipped; }
+
+    void print_stats() const;
+
+private:
+    struct Signature
+    {
+        uint32_t sum;
+        uint16_t min, max;
+    };
+
+    DepthFrame const &frame;
+    uint16_t ceiling, mean_delta, range_delta;
+    int tiles_x, tiles_y;
+    std::vector<Signature> previous;
+    std::vector<bool> dirty;
+    bool primed = false;
+
+    uint64_t tiles_checked = 0, tiles_dirty = 0;
+    uint64_t zones_checked = 0, zones_skipped = 0;
+};
@@ -6,6 +6,9 @@
 // Default I2C address for VL53L0X
 #define ADDRESS_DEFAULT 0b0101001
 
+// Fichier par défaut du cache de calibration des capteurs
+#define VL53L0X_CALIBRATION_FILE "vl53l0x_calibration.bin"
+
 /*
     VL53L0X class
     Provides a high-level interface to the VL53L0X time-of-flight distance sensor
@@ -14,13 +17,23 @@ class VL53L0X : public I2C_slave
 {
 public:
     // Constructeur avec adresse I2C
-    VL53L0X(uint8_t address = ADDRESS_DEFAULT);
+    VL53L0X(uint8_t address = ADDRESS_DEFAULT, const char *bus_path = I2C_DEVICE);
 
     // Destructeur par défaut
     ~VL53L0X() = default;
 
     // Initialise le capteur (vérifie MODEL_ID)
-    bool init(bool io_2v8 = true);
+    // Si calibration_file est donné, la calibration (SPAD, VHV, phase, stop_variable)
+    // y est relue au lieu d'être refaite, sauf si recalibrate est vrai ou si le
+    // capteur ne correspond pas à l'entrée du fichier.
+    bool init(bool io_2v8 = true, const char *calibration_file = nullptr, bool recalibrate = false);
+
+    // Durée du dernier init() en ms
+    inline uint32_t getInitDuration() { return init_duration_ms; }
+
+    // Lecture/écriture d'une entrée du cache de calibration (une entrée par uid)
+    static bool loadCalibration(const char *path, uint64_t uid, VL53L0XCalibration *cal);
+    static bool saveCalibration(const char *path, VL53L0XCalibration const *cal);
 
     // Reset logiciel du capteur
     bool reset();
@@ -37,6 +50,11 @@ public:
     void startContinuous(uint32_t period_ms = 0);
     void stopContinuous();
     uint16_t readRangeContinuousMillimeters();
+    // Lecture non bloquante en mode continu : false si aucune mesure n'est prête
+    // ou si le bus a échoué (timeoutOccurred() devient vrai)
+    // status reçoit l'état de la mesure (RANGE_STATUS_VALID si la distance est fiable)
+    bool readRangeIfReady(uint16_t *range, uint8_t *status = nullptr);
+    static constexpr uint8_t RANGE_STATUS_VALID = 11;
     uint16_t readRangeSingleMillimeters();
 
     inline void setTimeout(uint16_t timeout) { io_timeout = timeout; }
@@ -72,8 +90,16 @@ private:
 
     uint8_t stop_variable; // read by init and used when starting measurement; is StopVariable field of VL53L0X_DevData_t structure in API
     uint32_t measurement_timing_budget_us;
+    uint32_t init_duration_ms;
+
+    // Entête du fichier de calibration ("VLCA" + version)
+    static constexpr uint32_t CALIBRATION_MAGIC = 0x41434C56;
+    static constexpr uint32_t CALIBRATION_VERSION = 1;
 
     bool getSpadInfo(uint8_t *count, bool *type_is_aperture);
+    bool getPartUid(uint64_t *uid);
+    void getRefCalibration(uint8_t *vhv_settings, uint8_t *phase_cal);
+    void setRefCalibration(uint8_t vhv_settings, uint8_t phase_cal);
 
     void getSequenceStepEnables(SequenceStepEnables *enables);
     void getSequenceStepTimeouts(SequenceStepEnables const *enables, SequenceStepTimeouts *timeouts);
@@ -23,6 +23,21 @@ struct SequenceStepTimeouts
     uint32_t msrc_dss_tcc_us, pre_range_us, final_range_us;
 };
 
+// Résultat de la calibration d'un capteur, conservé entre deux démarrages
+// (voir VL53L0X::init()). Le champ uid identifie le module (lu en NVM), la
+// calibration n'est réutilisée que si uid et address correspondent.
+struct VL53L0XCalibration
+{
+    uint64_t uid;
+    uint8_t address;
+    uint8_t stop_variable;
+    uint8_t spad_count;
+    uint8_t spad_type_is_aperture;
+    uint8_t ref_spad_map[6]; // carte des SPAD de référence déjà filtrée
+    uint8_t vhv_settings;
+    uint8_t phase_cal;
+};
+
 // register addresses from API vl53l0x_device.h (ordered as listed there)
 enum regAddr
 {
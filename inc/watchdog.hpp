@@ -0,0 +1,48 @@
+#pragma once
+#include <atomic>
+#include <cstdint>
+#include <functional>
+#include <mutex>
+#include <thread>
+
+/*
+    Watchdog class
+    Surveille la boucle de commande : l'étage d'actionnement appelle heartbeat()
+    à chaque tick. Si aucun battement n'arrive avant deadline_ms (capture Kinect
+    bloquée sur l'USB, lecture i2c en timeout...), on_stall est appelé une fois
+    pour couper les moteurs, puis la durée du blocage est mesurée au battement suivant.
+*/
+class Watchdog
+{
+public:
+    Watchdog(uint32_t deadline_ms, std::function<void()> on_stall);
+    ~Watchdog();
+
+    void start();
+    void stop();
+
+    // Signale que la boucle de commande est vivante
+    void heartbeat();
+
+    inline uint32_t stall_count() const { return stalls; }
+
+    // nombre de blocages, durée totale et maximale
+    void print_stats() const;
+
+private:
+    uint32_t deadline_ms;
+    std::function<void()> on_stall;
+    std::thread worker;
+    std::atomic<bool> running{false};
+
+    std::atomic<uint64_t> last_beat_ms{0};
+    std::atomic<bool> stalled{false};
+
+    // statistiques (écrites par heartbeat() à la fin d'un blocage)
+    std::atomic<uint32_t> stalls{0};
+    mutable std::mutex stats_mutex;
+    uint64_t total_stall_ms = 0;
+    uint64_t max_stall_ms = 0;
+
+    void loop();
+};
@@ -0,0 +1,53 @@
+#pragma once
+#include <cstdint>
+#include <vector>
+
+enum ZoneFilterMode
+{
+    FILTER_NONE,     // valeur brute
+    FILTER_MEDIAN,   // médiane des ring_size dernières valeurs
+    FILTER_EMA,      // moyenne exponentielle de coefficient alpha
+    FILTER_ONE_EURO, // passe-bas dont la coupure monte avec la vitesse (Casiez 2012)
+};
+
+/*
+    ZoneFilter class
+    Filtre temporel des mesures de toutes les zones à la fois. Les états sont rangés
+    en SoA : une ligne de zones valeurs par position du ring, puis une ligne par état,
+    chaque étape est une boucle sur toutes les zones que le compilateur vectorise.
+*/
+class ZoneFilter
+{
+public:
+    static constexpr int MAX_RING = 9;
+
+    // ring_size : taille de la médiane (impaire, <= MAX_RING), alpha : coefficient de l'EMA
+    ZoneFilter(int zones, ZoneFilterMode mode, int ring_size = 5, float alpha = 0.3f);
+
+    // Réglage du filtre one-euro : coupure minimale (Hz), gain sur la vitesse, coupure de la vitesse (Hz)
+    void set_one_euro(float min_cutoff, float beta, float d_cutoff);
+
+    // Oublie l'historique : la prochaine mesure est reprise telle quelle
+    void reset();
+
+    // input et output : une valeur par zone ; dt : secondes depuis la mesure précédente
+    void update(float const *input, float *output, float dt);
+
+    // Retard de la sortie de la zone sur une entrée qui varie à vitesse constante, en secondes,
+    // pour des mesures espacées de dt
+    float group_delay(int zone, float dt) const;
+
+private:
+    int zones;
+    ZoneFilterMode mode;
+    int ring_size;
+    float alpha;
+    float min_cutoff = 1.0f, beta = 0.01f, d_cutoff = 1.0f;
+
+    int head = 0;
+    bool primed = false;
+    std::vector<float> ring;    // ring[k * zones + z]
+    std::vector<float> sorted;  // copie du ring triée colonne par colonne
+    std::vector<float> value;   // sortie précédente (EMA, one-euro)
+    std::vector<float> speed;   // dérivée filtrée (one-euro)
+};
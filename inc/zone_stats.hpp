@@ -0,0 +1,68 @@
+#pragma once
+#include <cstdint>
+#include <vector>
+
+// Statistiques d'une zone, dans l'unité de l'image (disparité brute ou mm)
+struct ZoneStats
+{
+    float mean;        // moyenne des pixels valides
+    uint16_t min;      // plus petit pixel valide
+    float percentile;  // percentile demandé, interpolé dans l'histogramme
+    float valid_ratio; // proportion de pixels valides dans la zone
+    float bound;       // demi-largeur de l'intervalle de confiance à 95% de la moyenne (0 : scan complet)
+};
+
+// Sous-ensemble fixe de pixels d'une zone, en offsets dans le buffer compact de la trame
+struct SamplePattern
+{
+    std::vector<uint32_t> offsets;
+};
+
+// Segment de pixels contigus d'une ligne du buffer compact
+struct PixelRun
+{
+    uint32_t offset;
+    uint32_t length;
+};
+
+// Pixels d'une zone dans le buffer compact de la trame : soit des segments de poids 1,
+// soit des offsets et leur poids en virgule fixe
+struct PixelTable
+{
+    std::vector<PixelRun> runs;
+    std::vector<uint32_t> offsets;
+    std::vector<uint16_t> weights;
+};
+
+/*
+    ZoneStatistics class
+    Calcule toutes les statistiques d'une zone en un seul passage sur ses pixels,
+    lus dans une image de la taille du buffer compact (profondeur ou hauteur).
+    Un pixel est valide s'il est inférieur à valid_max. Le percentile est lu dans
+    un histogramme de HIST_BINS classes de 2^shift unités couvrant [0, valid_max),
+    sans tri ; il est interpolé linéairement à l'intérieur de sa classe.
+*/
+class ZoneStatistics
+{
+public:
+    static constexpr int HIST_BINS = 256;
+
+    // percentile entre 0 et 100 (50 : médiane)
+    ZoneStatistics(uint16_t valid_max, float percentile);
+
+    // Statistiques sur tous les pixels de la table : segments sans branchement (vectorisés),
+    // puis pixels pondérés
+    ZoneStats gather(uint16_t const *data, PixelTable const &table);
+
+    // Estimation sur un sous-ensemble de pixels : coût indépendant de la taille de la zone
+    ZoneStats estimate(uint16_t const *data, SamplePattern const &pattern);
+
+private:
+    uint16_t valid_max;
+    float percentile;
+    int shift;
+    uint32_t histogram[HIST_BINS];
+
+    // percentile interpolé dans l'histogramme rempli, valid : effectif ou poids total
+    float histogram_percentile(uint32_t valid) const;
+};
@@ -0,0 +1,104 @@
+#include "background.hpp"
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+
+// 8 pixels par registre : SSE2 sur x86, NEON sur le Raspberry Pi
+typedef uint16_t u16x8 __attribute__((vector_size(16)));
+
+BackgroundModel::BackgroundModel(DepthFrame const &frame, uint16_t valid_max, float noise_k, uint16_t min_threshold)
+    : frame(frame), valid_max(valid_max), noise_k(noise_k), min_threshold(min_threshold)
+{
+    size_t n = frame.get_width() * frame.get_height();
+    background.assign(n, NO_VALUE);
+    threshold.assign(n, 0);
+    heights.assign(n, NO_VALUE);
+}
+
+void BackgroundModel::reset()
+{
+    size_t n = background.size();
+    frames = 0;
+    sum.assign(n, 0);
+    sum_sq.assign(n, 0);
+    count.assign(n, 0);
+}
+
+void BackgroundModel::accumulate()
+{
+    if (sum.empty())
+        reset();
+
+    uint16_t const *data = frame.get_data();
+    for (size_t i = 0; i < background.size(); i++)
+    {
+        uint32_t d = data[i];
+        if (d < valid_max)
+        {
+            sum[i] += d;
+            sum_sq[i] += d * d;
+            count[i]++;
+        }
+    }
+    frames++;
+}
+
+void BackgroundModel::finish()
+{
+    size_t valid = 0;
+    double total_sd = 0;
+
+    for (size_t i = 0; i < background.size(); i++)
+    {
+        if (count[i] == 0 || count[i] * 2 < frames)
+        {
+            background[i] = NO_VALUE;
+            threshold[i] = 0;
+            continue;
+        }
+        float mean = (float)sum[i] / count[i];
+        float sd = std::sqrt(std::max(0.0f, (float)sum_sq[i] / count[i] - mean * mean));
+        background[i] = (uint16_t)std::lround(mean);
+        threshold[i] = std::max<uint16_t>(min_threshold, (uint16_t)std::ceil(noise_k * sd));
+        total_sd += sd;
+        valid++;
+    }
+    coverage = background.empty() ? 0 : (float)valid / background.size();
+    noise = valid ? total_sd / valid : 0;
+
+    // les accumulateurs ne servent plus jusqu'à la prochaine calibration
+    std::vector<uint32_t>().swap(sum);
+    std::vector<uint32_t>().swap(sum_sq);
+    std::vector<uint16_t>().swap(count);
+}
+
+void BackgroundModel::extract()
+{
+    uint16_t const *depth = frame.get_data();
+    size_t n = background.size(), i = 0;
+    const u16x8 vmax = {valid_max, valid_max, valid_max, valid_max, valid_max, valid_max, valid_max, valid_max};
+
+    for (; i + 8 <= n; i += 8)
+    {
+        u16x8 d, b, t;
+        memcpy(&d, &depth[i], sizeof(d));
+        memcpy(&b, &background[i], sizeof(b));
+        memcpy(&t, &threshold[i], sizeof(t));
+
+        // masques : tous les bits à 1 si vrai ; un fond invalide (NO_VALUE) n'est jamais < vmax
+        u16x8 valid = (u16x8)(d < vmax) & (u16x8)(b < vmax);
+        u16x8 h = b - d;
+        u16x8 above = (u16x8)(b > d) & (u16x8)(h > t);
+        u16x8 out = (h & above & valid) | ~valid;
+        memcpy(&heights[i], &out, sizeof(out));
+    }
+    // fin du ROI, moins de 8 pixels
+    for (; i < n; i++)
+    {
+        uint16_t d = depth[i], b = background[i];
+        if (d >= valid_max || b >= valid_max)
+            heights[i] = NO_VALUE;
+        else
+            heights[i] = (b > d && b - d > threshold[i]) ? b - d : 0;
+    }
+}
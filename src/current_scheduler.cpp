@@ -0,0 +1,63 @@
+#include "current_scheduler.hpp"
+#include <algorithm>
+#include <cstdlib>
+
+CurrentScheduler::CurrentScheduler(int motors, int motors_per_supply, float budget_a, float run_a,
+                                   float inrush_a, uint16_t duty_min, uint16_t duty_max)
+    : motors(motors), motors_per_supply(motors_per_supply), budget_a(budget_a), run_a(run_a),
+      inrush_a(inrush_a), duty_min(duty_min), duty_max(duty_max)
+{
+    order.reserve(motors);
+    load.resize((motors + motors_per_supply - 1) / motors_per_supply);
+}
+
+float CurrentScheduler::current(uint16_t duty, bool running) const
+{
+    if (duty == 0)
+        return 0;
+    return run_a * duty / duty_max + (running ? 0 : inrush_a);
+}
+
+void CurrentScheduler::schedule(int16_t *duty, float const *remaining_s, bool const *running)
+{
+    order.clear();
+    for (int i = 0; i < motors; i++)
+        if (duty[i] != 0)
+            order.push_back(i);
+    std::sort(order.begin(), order.end(), [&](int a, int b)
+              {
+                  if (running[a] != running[b])
+                      return running[a];
+                  return remaining_s[a] > remaining_s[b];
+              });
+
+    std::fill(load.begin(), load.end(), 0.0f);
+    for (int i : order)
+    {
+        float &supply = load[i / motors_per_supply];
+        uint16_t wanted = std::abs(duty[i]);
+        float need = current(wanted, running[i]);
+        if (supply + need <= budget_a)
+        {
+            supply += need;
+            continue;
+        }
+
+        // plus forte commande qui tient dans le reste du budget
+        float left = budget_a - supply - (running[i] ? 0 : inrush_a);
+        uint16_t allowed = left > 0 ? (uint16_t)std::min<float>(left / run_a * duty_max, wanted) : 0;
+        if (allowed >= duty_min)
+        {
+            duty[i] = duty[i] > 0 ? allowed : -allowed;
+            supply += current(allowed, running[i]);
+            limited++;
+        }
+        else
+        {
+            duty[i] = 0;
+            deferred++;
+        }
+    }
+    for (float supply : load)
+        peak_a = std::max(peak_a, supply);
+}
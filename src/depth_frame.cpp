@@ -0,0 +1,58 @@
+#include "depth_frame.hpp"
+#include <algorithm>
+#include <cstring>
+#include <ctime>
+
+DepthFrame::DepthFrame(std::vector<Rect> const &rects) : width(0), height(0), timestamp(0), time_us(0)
+{
+    bool row_used[KINECT_H] = {};
+    bool col_used[KINECT_W] = {};
+
+    // marque les lignes et colonnes couvertes, rectangles rognés à l'image
+    for (auto const &r : rects)
+    {
+        for (int y = std::max(r.y, 0); y < std::min(r.y + r.h, KINECT_H); y++)
+            row_used[y] = true;
+        for (int x = std::max(r.x, 0); x < std::min(r.x + r.w, KINECT_W); x++)
+            col_used[x] = true;
+    }
+
+    for (int y = 0; y < KINECT_H; y++)
+    {
+        row_of[y] = row_used[y] ? height++ : -1;
+        if (row_used[y])
+            rows.push_back(y);
+    }
+    for (int x = 0; x < KINECT_W; x++)
+    {
+        col_of[x] = col_used[x] ? width++ : -1;
+        if (!col_used[x])
+            continue;
+        // colonnes consécutives regroupées pour être copiées d'un bloc
+        if (!col_spans.empty() && col_spans.back().from + col_spans.back().len == x)
+            col_spans.back().len++;
+        else
+            col_spans.push_back({x, 1});
+    }
+
+    data.assign(width * height, 0);
+}
+
+void DepthFrame::capture(uint16_t const *full, uint32_t timestamp)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    time_us = (uint64_t)ts.tv_sec * 1000000 + ts.tv_nsec / 1000;
+
+    uint16_t *dst = data.data();
+    for (int y : rows)
+    {
+        uint16_t const *src = &full[y * KINECT_W];
+        for (auto const &span : col_spans)
+        {
+            memcpy(dst, &src[span.from], span.len * sizeof(uint16_t));
+            dst += span.len;
+        }
+    }
+    this->timestamp = timestamp;
+}
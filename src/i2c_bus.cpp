@@ -0,0 +1,127 @@
+#include "i2c_bus.hpp"
+#include <fcntl.h>
+#include <unistd.h>
+#include <cerrno>
+
+I2C_bus *I2C_bus::buses[MAX_BUSES];
+int I2C_bus::nb_buses = 0;
+std::mutex I2C_bus::buses_mutex;
+
+I2C_bus::I2C_bus(const char *path) : path(path), fd(-1), dev_ctn(0), executor(nullptr)
+{
+}
+
+I2C_bus::~I2C_bus()
+{
+    close_bus();
+}
+
+I2C_bus *I2C_bus::acquire(const char *path)
+{
+    std::lock_guard<std::mutex> lock(buses_mutex);
+
+    I2C_bus *bus = nullptr;
+    for (int i = 0; i < nb_buses && !bus; i++)
+        if (buses[i]->path == path)
+            bus = buses[i];
+    if (!bus)
+    {
+        if (nb_buses == MAX_BUSES)
+        {
+            errno = EMFILE;
+            return nullptr;
+        }
+        bus = new I2C_bus(path);
+        if (!bus->open_bus())
+        {
+            int err = errno;
+            delete bus;
+            errno = err;
+            return nullptr;
+        }
+        buses[nb_buses++] = bus;
+    }
+    bus->dev_ctn++;
+    return bus;
+}
+
+void I2C_bus::release(I2C_bus *bus)
+{
+    std::lock_guard<std::mutex> lock(buses_mutex);
+
+    if (--bus->dev_ctn > 0)
+        return;
+    for (int i = 0; i < nb_buses; i++)
+    {
+        if (buses[i] == bus)
+        {
+            buses[i] = buses[--nb_buses];
+            break;
+        }
+    }
+    delete bus;
+}
+
+bool I2C_bus::open_bus()
+{
+    errno = 0;
+    fd = open(path.c_str(), O_RDWR);
+    if (fd < 0)
+    {
+        // Erreur quelconque à l'ouverture du bus
+        perror("Error opening I2C device");
+        return false;
+    }
+    executor = new I2C_executor(fd);
+    printf("I2C initialized on %s\n", path.c_str());
+    return true;
+}
+
+bool I2C_bus::close_bus()
+{
+    errno = 0;
+    if (fd < 0)
+        return false;
+
+    delete executor; // arrête le thread avant de fermer le descripteur
+    executor = nullptr;
+    if (close(fd) == 0)
+    {
+        printf("I2C bus %s closed\n", path.c_str());
+        fd = -1;
+        return true;
+    }
+    perror("cannot close i2c bus");
+    return false;
+}
+
+void I2C_bus::start_all()
+{
+    std::lock_guard<std::mutex> lock(buses_mutex);
+    for (int i = 0; i < nb_buses; i++)
+        buses[i]->executor->start();
+}
+
+void I2C_bus::stop_all()
+{
+    std::lock_guard<std::mutex> lock(buses_mutex);
+    for (int i = 0; i < nb_buses; i++)
+        buses[i]->executor->stop();
+}
+
+void I2C_bus::print_stats_all()
+{
+    std::lock_guard<std::mutex> lock(buses_mutex);
+    for (int i = 0; i < nb_buses; i++)
+    {
+        printf("[%s] ", buses[i]->path.c_str());
+        buses[i]->executor->print_stats();
+    }
+}
+
+bool I2C_bus::transfer(struct i2c_msg *msgs, uint32_t nmsgs, I2C_priority priority)
+{
+    // thread du bus ou appel direct sous verrou : choisi par l'executor en un seul test,
+    // les attentes (calibration, oscillateur...) se font hors du verrou
+    return executor->execute(priority, msgs, nmsgs);
+}
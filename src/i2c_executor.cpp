@@ -0,0 +1,215 @@
+#include "i2c_executor.hpp"
+#include <sys/ioctl.h>
+#include <cerrno>
+#include <cstdio>
+#include <ctime>
+
+volatile sig_atomic_t I2C_executor::actuation_hold = 0;
+bool (*I2C_executor::emergency_resend)() = nullptr;
+
+static const char *priority_names[I2C_PRIO_COUNT] = {"urgence", "actionneurs", "capteurs", "diagnostic"};
+
+// temps monotone en ns
+static uint64_t now_ns()
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000000000ull + ts.tv_nsec;
+}
+
+I2C_executor::I2C_executor(int fd) : fd(fd)
+{
+    sem_init(&pending, 0, 0);
+}
+
+I2C_executor::~I2C_executor()
+{
+    stop();
+    sem_destroy(&pending);
+}
+
+void I2C_executor::start()
+{
+    if (running())
+        return;
+    // réveils restés d'un arrêt précédent (transactions déjà terminées en échec)
+    while (sem_trywait(&pending) == 0)
+        ;
+    stopping = false;
+    start_ns = now_ns();
+    busy_ns = 0;
+    worker = std::thread(&I2C_executor::loop, this);
+    // lu par execute() depuis d'autres threads : worker lui-même ne l'est pas pendant join()
+    worker_id = worker.get_id();
+}
+
+void I2C_executor::stop()
+{
+    if (!running())
+        return;
+    stopping = true;
+    sem_post(&pending); // réveille le thread
+    worker.join();
+    worker_id = std::thread::id();
+}
+
+bool I2C_executor::rdwr(int fd, struct i2c_msg *msgs, uint32_t nmsgs)
+{
+    struct i2c_rdwr_ioctl_data ioctl_data;
+
+    // le noyau limite le nombre de messages par appel
+    for (uint32_t i = 0; i < nmsgs; i += I2C_RDWR_IOCTL_MAX_MSGS)
+    {
+        ioctl_data.msgs = &msgs[i];
+        ioctl_data.nmsgs = (nmsgs - i) < I2C_RDWR_IOCTL_MAX_MSGS ? (nmsgs - i) : I2C_RDWR_IOCTL_MAX_MSGS;
+
+        errno = 0;
+        if (ioctl(fd, I2C_RDWR, &ioctl_data) < 0)
+            return false;
+    }
+    return true;
+}
+
+bool I2C_executor::write(I2C_priority priority, struct i2c_msg *msgs, uint32_t nmsgs)
+{
+    std::lock_guard<std::mutex> lock(bus_mutex);
+    bool ok = rdwr(fd, msgs, nmsgs);
+    // verrou posé pendant l'écriture : la coupure est peut-être partie avant cette trame,
+    // qui a rallumé les sorties
+    if (priority == I2C_PRIO_ACTUATION && actuation_hold && emergency_resend)
+    {
+        int err = errno;
+        emergency_resend();
+        errno = err;
+    }
+    return ok;
+}
+
+bool I2C_executor::enqueue(I2C_priority priority, Transaction &&t)
+{
+    if (stopping || !queues[priority].push(std::move(t)))
+        return false;
+    // arrêt demandé pendant le dépôt : le thread a peut-être déjà vidé les files
+    if (stopping)
+    {
+        fail_pending();
+        return true;
+    }
+
+    uint32_t depth = queues[priority].size();
+    uint32_t max = max_depth[priority].load(std::memory_order_relaxed);
+    while (depth > max && !max_depth[priority].compare_exchange_weak(max, depth))
+        ;
+    sem_post(&pending);
+    return true;
+}
+
+std::future<bool> I2C_executor::submit(I2C_priority priority, struct i2c_msg *msgs, uint32_t nmsgs)
+{
+    Transaction t;
+    t.msgs = msgs;
+    t.nmsgs = nmsgs;
+    std::future<bool> result = t.done.get_future();
+    if (!enqueue(priority, std::move(t)))
+    {
+        // file pleine ou executor en arrêt : la transaction n'a pas été prise, on la résout ici
+        errno = stopping ? ESHUTDOWN : EAGAIN;
+        t.done.set_value(false);
+    }
+    return result;
+}
+
+bool I2C_executor::submit(I2C_priority priority, struct i2c_msg *msgs, uint32_t nmsgs, std::function<void(bool)> callback)
+{
+    Transaction t;
+    t.msgs = msgs;
+    t.nmsgs = nmsgs;
+    t.callback = std::move(callback);
+    return enqueue(priority, std::move(t));
+}
+
+bool I2C_executor::execute(I2C_priority priority, struct i2c_msg *msgs, uint32_t nmsgs)
+{
+    // décidé une seule fois : un stop() entre ce test et l'écriture reste sous bus_mutex
+    if (!running() || std::this_thread::get_id() == worker_id.load())
+        return write(priority, msgs, nmsgs);
+    return submit(priority, msgs, nmsgs).get();
+}
+
+void I2C_executor::loop()
+{
+    Transaction t;
+    for (;;)
+    {
+        sem_wait(&pending);
+        if (stopping)
+            break;
+
+        // classe la plus urgente en premier ; une transaction comptée par le sémaphore
+        // est forcément publiée, on finit toujours par la trouver
+        int p = 0;
+        while (!queues[p].pop(t))
+            p = (p + 1) % I2C_PRIO_COUNT;
+
+        // commande moteur déposée avant l'arrêt d'urgence : elle rallumerait les sorties
+        if (p == I2C_PRIO_ACTUATION && actuation_hold)
+        {
+            failed[p]++;
+            if (t.callback)
+                t.callback(false);
+            else
+                t.done.set_value(false);
+            t = Transaction();
+            continue;
+        }
+
+        uint64_t t0 = now_ns();
+        bool ok = write((I2C_priority)p, t.msgs, t.nmsgs);
+        int err = errno;
+        busy_ns += now_ns() - t0;
+
+        (ok ? completed : failed)[p]++;
+        errno = err;
+        if (t.callback)
+            t.callback(ok);
+        else
+            t.done.set_value(ok);
+        t = Transaction();
+    }
+
+    // transactions restantes : en échec, pour ne laisser personne en attente
+    fail_pending();
+}
+
+void I2C_executor::fail_pending()
+{
+    Transaction t;
+    for (int p = 0; p < I2C_PRIO_COUNT; p++)
+    {
+        while (queues[p].pop(t))
+        {
+            failed[p]++;
+            if (t.callback)
+                t.callback(false);
+            else
+                t.done.set_value(false);
+            t = Transaction();
+        }
+    }
+}
+
+float I2C_executor::utilisation() const
+{
+    uint64_t elapsed = now_ns() - start_ns;
+    return elapsed ? (float)busy_ns.load() / elapsed : 0.0f;
+}
+
+void I2C_executor::print_stats() const
+{
+    printf("===== BUS I2C : utilisation %.1f %% =====\n", utilisation() * 100.0f);
+    for (int p = 0; p < I2C_PRIO_COUNT; p++)
+    {
+        printf("%-12s attente %3zu (max %3u) | faites %8u | erreurs %u\n", priority_names[p],
+               queue_depth((I2C_priority)p), max_depth[p].load(), completed[p].load(), failed[p].load());
+    }
+}
@@ -1,66 +1,45 @@
 #include "i2c_slave.hpp"
 
-uint8_t I2C_slave::dev_ctn = 0;
-bool I2C_slave::dev_initialized = false;
-int I2C_slave::fd = -1;
-
-I2C_slave::I2C_slave(uint8_t addr) : addr(addr)
+I2C_slave::I2C_slave(uint8_t addr, I2C_priority priority, const char *bus_path) : addr(addr), priority(priority)
 {
-    if (!dev_initialized)
-    {
-        if (!bus_open())
-            exit(errno); // on se permet de quitter directement car c'est une erreur fatale
-        dev_initialized = true;
-    };
-    dev_ctn++;
+    bus = I2C_bus::acquire(bus_path);
+    if (!bus)
+        exit(errno); // on se permet de quitter directement car c'est une erreur fatale
 };
 
-I2C_slave::~I2C_slave()
+I2C_slave::I2C_slave(I2C_slave const &other) : addr(other.addr), last_status(other.last_status), priority(other.priority)
 {
-    if (--dev_ctn < 1)
-    {
-        if (!bus_close())
-            exit(errno);
-        dev_initialized = false;
-    }
+    bus = I2C_bus::acquire(other.bus->get_path());
+    if (!bus)
+        exit(errno);
 }
 
-bool I2C_slave::bus_open()
+I2C_slave &I2C_slave::operator=(I2C_slave const &other)
 {
-    errno = 0;
-    fd = open(I2C_DEVICE, O_RDWR);
-    if (errno)
+    if (this != &other)
     {
-        // Erreur quelconque à l'ouverture du bus
-        perror("Error opening I2C device");
-        return false;
+        // le nouveau bus est référencé avant de rendre l'ancien, qui peut être le même
+        I2C_bus *new_bus = I2C_bus::acquire(other.bus->get_path());
+        if (!new_bus)
+            exit(errno);
+        I2C_bus::release(bus);
+        bus = new_bus;
+        addr = other.addr;
+        last_status = other.last_status;
+        priority = other.priority;
     }
-    printf("I2C initialized on %s\n", I2C_DEVICE);
-    return true;
+    return *this;
 }
 
-bool I2C_slave::bus_close()
+I2C_slave::~I2C_slave()
 {
-    errno = 0;
-    if (dev_initialized)
-    {
-        if (close(I2C_slave::fd) == 0)
-        {
-            printf("I2C bus closed\n");
-            dev_initialized = false;
-            fd = -1;
-            return true;
-        }
-        perror("cannot close i2c bus");
-    }
-    return false;
+    I2C_bus::release(bus);
 }
 
 bool I2C_slave::write(uint8_t reg, uint8_t value)
 {
     uint8_t buf[2];
     struct i2c_msg msg;
-    struct i2c_rdwr_ioctl_data ioctl_data;
 
     // envoie dans un premier temps de l'addresse à laquelle on va modifier des données (premier octet)
     // envoie dans un second temps de la nouvelle valeur de ce registre (deuxième octet)
@@ -71,11 +50,7 @@ bool I2C_slave::write(uint8_t reg, uint8_t value)
     msg.len = 2;
     msg.buf = buf;
 
-    ioctl_data.msgs = &msg;
-    ioctl_data.nmsgs = 1;
-
-    errno = 0;
-    if (ioctl(fd, I2C_RDWR, &ioctl_data) < 0)
+    if (!transfer(&msg, 1))
     {
         perror("Error writing register");
         return false;
@@ -96,7 +71,6 @@ bool I2C_slave::write(uint8_t reg, uint32_t value)
 bool I2C_slave::write(uint8_t reg, uint8_t *data, uint32_t sdata)
 {
     struct i2c_msg msg;
-    struct i2c_rdwr_ioctl_data ioctl_data;
 
     // copie des données dans un nouveau buffer de taille sdata + 1 pour mettre en en-tête l'addresse du registre
     uint8_t buf[sdata + 1];
@@ -109,11 +83,7 @@ bool I2C_slave::write(uint8_t reg, uint8_t *data, uint32_t sdata)
     msg.len = sdata + 1;
     msg.buf = buf;
 
-    ioctl_data.msgs = &msg;
-    ioctl_data.nmsgs = 1;
-
-    errno = 0;
-    if (ioctl(fd, I2C_RDWR, &ioctl_data) < 0)
+    if (!transfer(&msg, 1))
     {
         perror("Error writing multiple bytes");
         return false;
@@ -141,11 +111,30 @@ bool I2C_slave::write(uint8_t reg, uint32_t *data, uint32_t sdata)
     return write(reg, reinterpret_cast<uint8_t *>(data), 4 * sdata);
 }
 
+bool I2C_slave::write(RegWrite const *seq, uint32_t count)
+{
+    struct i2c_msg msgs[count];
+
+    // RegWrite est déjà au format d'un message d'écriture (registre puis valeur)
+    for (uint32_t i = 0; i < count; i++)
+    {
+        msgs[i].addr = this->addr;
+        msgs[i].flags = 0;
+        msgs[i].len = sizeof(RegWrite);
+        msgs[i].buf = const_cast<uint8_t *>(&seq[i].reg);
+    }
+    if (!transfer(msgs, count))
+    {
+        perror("Error writing register sequence");
+        return false;
+    }
+    return true;
+}
+
 bool I2C_slave::read(uint8_t reg, uint8_t *value)
 {
     uint8_t buf = reg;
     struct i2c_msg msgs[2];
-    struct i2c_rdwr_ioctl_data ioctl_data;
 
     // Premier message: envoie de l'addresse du registre qu'on veut lire
     msgs[0].addr = this->addr;
@@ -159,11 +148,7 @@ bool I2C_slave::read(uint8_t reg, uint8_t *value)
     msgs[1].len = 1;
     msgs[1].buf = value;
 
-    ioctl_data.msgs = msgs;
-    ioctl_data.nmsgs = 2;
-
-    errno = 0;
-    if (ioctl(fd, I2C_RDWR, &ioctl_data) < 0)
+    if (!transfer(msgs, 2))
     {
         perror("Error reading register");
         return false;
@@ -185,7 +170,6 @@ bool I2C_slave::read(uint8_t reg, uint8_t *data, uint32_t sdata)
 {
     uint8_t buf = reg;
     struct i2c_msg msgs[2];
-    struct i2c_rdwr_ioctl_data ioctl_data;
 
     // Premier message: envoie de l'addresse du registre qu'on veut lire
     msgs[0].addr = this->addr;
@@ -199,11 +183,7 @@ bool I2C_slave::read(uint8_t reg, uint8_t *data, uint32_t sdata)
     msgs[1].len = sdata;
     msgs[1].buf = data;
 
-    ioctl_data.msgs = msgs;
-    ioctl_data.nmsgs = 2;
-
-    errno = 0;
-    if (ioctl(fd, I2C_RDWR, &ioctl_data) < 0)
+    if (!transfer(msgs, 2))
     {
         perror("Error reading multiple bytes");
         return false;
@@ -1,68 +1,333 @@
 #include "test.hpp"
+#include "motor_config.hpp"
+#include "startup.hpp"
+#include "pwm_bank.hpp"
+#include "watchdog.hpp"
+#include "kinect_depth.hpp"
+#include "depth_frame.hpp"
+#include "tile_detector.hpp"
+#include "zone_stats.hpp"
+#include "pin_mapping.hpp"
+#include "background.hpp"
+#include "zone_filter.hpp"
+#include "mailbox.hpp"
+#include "motion_profile.hpp"
+#include "current_scheduler.hpp"
+#include "speed_model.hpp"
+#include "pin_state.hpp"
+#include "sensor_poller.hpp"
+#include "sensor_health.hpp"
+#include <atomic>
+#include <thread>
 
-#define COLS 2
-#define ROWS 2
-#define TOTAL_MOTORS (COLS * ROWS)
+// Mode de traitement de la profondeur :
+// 1 : disparité brute 11 bits, agrégée telle quelle, seuls les résultats par zone sont convertis en mm
+// 0 : profondeur en mm convertie par libfreenect pour chaque pixel
+#define DEPTH_RAW 1
+
+// Statistique de zone utilisée pour la cible des pins :
+// 1 : percentile ZONE_PERCENTILE de la profondeur, insensible aux bords et aux trous d'ombre
+// 0 : moyenne des pixels valides
+#define ZONE_ROBUST 1
+
+// Compensation de latence : la cible de chaque zone est extrapolée à vitesse constante
+// jusqu'à l'instant où la commande s'applique
+// 1 : cible prédite, 0 : cible de la dernière trame
+#define PREDICT_TARGETS 1
+
+// nombre de PCA9685 (adresses consécutives à partir de 0x40), 8 moteurs par carte
+#define PWM_BOARDS ((TOTAL_MOTORS + PwmBank::MOTORS_PER_BOARD - 1) / PwmBank::MOTORS_PER_BOARD)
 
 const int K_WIDTH = 640;
 const int K_HEIGHT = 320;
-const int ZONE_W = K_WIDTH / COLS;
-const int ZONE_H = K_HEIGHT / ROWS;
-
-const float VITESSE_MM_S = 14.0;
-const float COURSE_MAX = 70.0;
-const int VMAX = 4095;
-const int VOFF = 0;
-const int VMOY = 2500;
+// côté en pixels de la fenêtre échantillonnée au centre de chaque pin (disposition par défaut)
+const int PIN_SAMPLE_PX = 40;
+// pixels pondérés en tente (centre du pin privilégié) ; sinon parcours vectorisé, poids égaux
+const bool PIN_TENT_WEIGHTS = false;
+// percentile de profondeur d'une zone (50 : médiane, plus bas : objet le plus proche)
+// pris sur la hauteur au-dessus du sol de chaque pixel
+const float ZONE_PERCENTILE = 50;
+// en dessous de cette proportion de pixels valides la zone est considérée vide (sol)
+const float ZONE_MIN_VALID = 0.25f;
+// pixels échantillonnés par zone (0 : scan complet de chaque zone)
+const int ZONE_SAMPLES = 96;
+// précision voulue sur la hauteur des pins : au-delà, la zone est parcourue entièrement
+const float ZONE_TOLERANCE_MM = 1.0f;
+// modèle du sol : trames accumulées à la calibration, seuil de bruit en écarts types
+const int BACKGROUND_FRAMES = 30;
+const float BACKGROUND_NOISE_K = 3.0f;
+// filtre temporel des profondeurs de zone (FILTER_NONE, FILTER_MEDIAN, FILTER_EMA, FILTER_ONE_EURO)
+const ZoneFilterMode ZONE_FILTER = FILTER_MEDIAN;
+const int ZONE_FILTER_SIZE = 5;      // trames de la médiane
+const float ZONE_FILTER_ALPHA = 0.3f; // coefficient de l'EMA
+// exposition -> réception de la trame (transfert USB, tampon freenect_sync), invisible depuis l'hôte
+const float KINECT_TRANSPORT_MS = 40.0f;
+// horizon de prédiction maximal, au-delà la vitesse estimée n'est plus fiable
+const float PREDICTION_MAX_MS = 200.0f;
+// boucle d'actionnement, découplée de la Kinect
+const int ACTUATION_HZ = 250;
+// sans nouvelle cible de la vision pendant ce délai, les moteurs s'arrêtent où ils sont
+const int VISION_TIMEOUT_MS = 500;
+// part de l'écart mesuré par le VL53L0X corrigée à chaque lecture
+const float TOF_GAIN = 0.5f;
+// lecture des VL53L0X selon l'état du moteur : en mouvement à chaque mesure du capteur,
+// pendant TOF_SETTLE_MS après l'arrêt, puis en contrôle de dérive ; temps i2c maximal par tick
+const uint32_t TOF_INTERVAL_US[3] = {33000, 100000, 1000000};
+const int TOF_SETTLE_MS = 300;
+const uint32_t TOF_BUDGET_US = 1000;
+// santé des VL53L0X : sans mesure 200 ms = timeout ; quarantaine au-delà de 30 % de timeouts,
+// 50 % de mesures invalides ou 15 distances identiques moteur en marche (jugé après 20 événements) ;
+// réinitialisation en arrière-plan, nouvel essai après 1 s puis 2 s... jusqu'à 30 s
+const SensorHealthConfig TOF_HEALTH = {200000, 0.3f, 0.5f, 15, 20, 1000, 30000};
+// apprentissage des vitesses : durée minimale d'une mesure à commande constante, part corrigée
+const int SPEED_WINDOW_MS = 300;
+const float SPEED_LEARN_GAIN = 0.2f;
+// sauvegarde des positions des pins pendant le fonctionnement (PIN_STATE_FILE)
+const int STATE_CHECKPOINT_MS = 100;
+// à l'arrêt, ramène les pins à OFFSET avant de couper (sinon ils restent où ils sont,
+// leur position est reprise au démarrage suivant)
+const bool PARK_ON_EXIT = false;
+// retour en position de référence (OFFSET) : arrêt quand le VL53L0X reste dans DEAD_BAND_MM
+// pendant HOMING_SETTLE_MS, ou sur calage (moins de HOMING_STALL_MM en HOMING_STALL_MS moteur
+// commandé) ; commande réduite à VMOY à moins de HOMING_SLOW_MM de la cible
+const int HOMING_SETTLE_MS = 100;
+const int HOMING_STALL_MS = 300;
+const float HOMING_STALL_MM = 0.5f;
+const float HOMING_SLOW_MM = 5.0f;
+// pins sans capteur : descente en butée basse, durée calculée sur la courbe de vitesse plus cette marge ;
+// un capteur sans mesure valide pendant HOMING_STALL_MS fait passer son pin sur ce chemin
+const float HOMING_MARGIN_MM = 5.0f;
+const int HOMING_TIMEOUT_MS = 10000;
+
 const int OFFSET = 0;
+// profils de mouvement : accélération, paliers de VMOY à VMAX, écart toléré à la cible
+const float ACCEL_MM_S2 = 40.0f;
+const int PROFILE_LEVELS = 4;
+const float DEAD_BAND_MM = 1.2f;
+// budget de courant : moteurs consécutifs sur une même alimentation, courant admissible,
+// courant d'un moteur à VMAX et surplus le tick où il démarre
+const int MOTORS_PER_SUPPLY = 8;
+const float SUPPLY_BUDGET_A = 2.0f;
+const float MOTOR_RUN_A = 0.35f;
+const float MOTOR_INRUSH_A = 0.6f;
+
+// période nominale de la boucle de commande : trame Kinect (~33 ms) + pause de 20 ms
+const uint32_t LOOP_PERIOD_MS = 60;
+// moteurs coupés si l'actionnement ne tourne plus pendant WATCHDOG_PERIODS périodes (100 ms)
+const uint32_t WATCHDOG_PERIODS = 25;
 
 const float DIST_SOL = 900.0f;
 const float DIST_OBJ_MAX = 500.0f;
 
+// VL53L0X de chaque moteur : bus et adresse i2c (adresse 0 : pas de capteur)
+// répartir les capteurs sur plusieurs bus (/dev/i2c-3, /dev/i2c-4...) multiplie le débit disponible
+// zero_mm : distance lue quand le pin est en position 0, le capteur vise le pin par au-dessus
+struct TofConfig
+{
+    const char *bus;
+    uint8_t addr;
+    uint16_t zero_mm;
+};
+const TofConfig TOF[TOTAL_MOTORS] = {};
+
+#if DEPTH_RAW
+const freenect_depth_format DEPTH_FORMAT = FREENECT_DEPTH_11BIT;
+// pixels utilisés : profondeur < 2400 mm, soit une disparité inférieure à ce seuil (calculé à la compilation)
+constexpr uint16_t DEPTH_VALID_MAX = mm_to_disparity(2400);
+static inline float zone_depth_mm(float mean) { return mean_disparity_to_mm(mean); }
+static inline uint16_t pixel_depth_mm(uint16_t d) { return disparity_to_mm(d); }
+static inline float depth_level(float mm) { return mm_to_disparity(mm); }
+// détection de changement par tuile : écart de moyenne et de min/max, en unités de disparité
+const uint16_t TILE_MEAN_DELTA = 2;
+const uint16_t TILE_RANGE_DELTA = 8;
+// écart minimal au sol d'un pixel, même si son bruit mesuré est plus faible
+const uint16_t BACKGROUND_MIN_THRESHOLD = 2;
+#else
+const freenect_depth_format DEPTH_FORMAT = FREENECT_DEPTH_MM;
+constexpr uint16_t DEPTH_VALID_MAX = 2400;
+static inline float zone_depth_mm(float mean) { return mean; }
+static inline uint16_t pixel_depth_mm(uint16_t d) { return d; }
+static inline float depth_level(float mm) { return mm; }
+const uint16_t TILE_MEAN_DELTA = 10;
+const uint16_t TILE_RANGE_DELTA = 40;
+const uint16_t BACKGROUND_MIN_THRESHOLD = 10;
+#endif
+
 static float reference_depth[TOTAL_MOTORS];
+// niveau du sol de chaque pin dans l'unité de la trame, moyenne du modèle de fond sur ses pixels
+static float floor_level[TOTAL_MOTORS];
 
+// Les champs de la vision et ceux de l'actionnement ne sont touchés que par leur propre thread
 struct MotorState
 {
-    float current_pos = OFFSET;
+    // vision
     float target_pos = 0;
-    float avg_depth_mm = 0; // Stocke la distance moyenne vue par la Kinect pour cette zone
+    float depth_mm = 0;    // Stocke la distance vue par la Kinect pour cette zone (moyenne ou percentile)
+    float valid_ratio = 0; // proportion de pixels valides dans la zone
+    // actionnement
+    float current_pos = OFFSET;
+    float setpoint = OFFSET; // cible interpolée entre deux trames
+    bool settled = false;    // à l'arrêt sur sa cible, rien à replanifier tant que la cible ne change pas
+    float goal = OFFSET;     // cible du profil en cours
+    TrapezoidProfile profile;
+    uint64_t profile_start_us = 0;
+    int16_t duty = 0; // commande appliquée, signée
+    uint64_t stopped_us = 0; // dernier passage à l'arrêt
+    // mesure de vitesse en cours : première lecture VL53L0X à la commande window_duty
+    float window_pos = 0;
+    uint64_t window_us = 0;
+    int16_t window_duty = 0;
 };
 
 static MotorState moteurs[TOTAL_MOTORS];
-static PCA9685 pca;
+// mêmes moteurs conduits par les cibles non filtrées, sans sortie : écritures évitées par le filtre
+static MotorState shadow_moteurs[TOTAL_MOTORS];
+
+// Correspondance grille de pins -> pixels, ajustée sur les points de PIN_MAPPING_FILE.
+// Sans fichier, la grille est alignée sur le rectangle K_WIDTH x K_HEIGHT de l'image (Kinect à la verticale).
+static PinMapping load_pin_mapping()
+{
+    // fenêtre en fraction de la cellule de K_WIDTH / COLS x K_HEIGHT / ROWS pixels
+    PinMapping mapping(COLS, ROWS, (float)PIN_SAMPLE_PX * COLS / K_WIDTH, (float)PIN_SAMPLE_PX * ROWS / K_HEIGHT,
+                       K_WIDTH, K_HEIGHT);
+    mapping.load(PIN_MAPPING_FILE);
+    return mapping;
+}
+static PinMapping mapping = load_pin_mapping();
+
+// ROI : union des boîtes englobantes de tous les pins, seule partie de l'image copiée et traitée
+static std::vector<Rect> zone_windows()
+{
+    std::vector<Rect> windows;
+    for (int i = 0; i < TOTAL_MOTORS; i++)
+        windows.push_back(mapping.bounds(i));
+    return windows;
+}
+static DepthFrame frame(zone_windows());
+static TileDetector tiles(frame, DEPTH_VALID_MAX, TILE_MEAN_DELTA, TILE_RANGE_DELTA);
+static BackgroundModel background(frame, DEPTH_VALID_MAX, BACKGROUND_NOISE_K, BACKGROUND_MIN_THRESHOLD);
+// statistiques sur l'image de hauteur : percentile p de la profondeur = 100 - p de la hauteur
+static ZoneStatistics zone_stats(DEPTH_VALID_MAX, 100 - ZONE_PERCENTILE);
+static SamplePattern sample_patterns[TOTAL_MOTORS];
+static uint64_t zones_sampled = 0, zones_scanned = 0;
+
+// profondeur brute de chaque zone, avant filtrage, et cible qu'elle donnerait
+static float raw_depth[TOTAL_MOTORS];
+static float raw_target[TOTAL_MOTORS];
+static ZoneFilter depth_filter(TOTAL_MOTORS, ZONE_FILTER, ZONE_FILTER_SIZE, ZONE_FILTER_ALPHA);
+
+// vitesse de la cible de chaque zone (mm/s)
+static float last_target[TOTAL_MOTORS];
+static float target_speed[TOTAL_MOTORS];
+
+// Cibles publiées par la vision à chaque trame, lues par la boucle d'actionnement
+struct TargetSet
+{
+    float target[TOTAL_MOTORS];     // cible filtrée et prédite
+    float unfiltered[TOTAL_MOTORS]; // cible brute, pour compter les écritures évitées par le filtre
+    uint64_t time_us;               // réception de la trame
+};
+
+// État de l'actionnement publié pour l'affichage
+struct ActuationState
+{
+    float position[TOTAL_MOTORS];
+    float setpoint[TOTAL_MOTORS];
+    float rate_hz;
+    uint64_t motors_planned, motors_skipped;
+    // transactions PWM avec et sans le filtre (mêmes profils et même budget, sur les cibles brutes)
+    uint64_t pwm_transactions, unfiltered_transactions;
+    // arbitrage du courant : commandes différées, bridées, plus forte charge d'une alimentation
+    uint64_t motors_deferred, motors_limited;
+    float supply_peak_a;
+    // VL53L0X : interrogations, mesures reçues, lectures reportées faute de budget i2c
+    uint64_t tof_polls, tof_readings, tof_deferred;
+};
+
+static Mailbox<TargetSet> targets;
+static Mailbox<ActuationState> actuation_state;
+static ActuationState actuation = {};
+static PinStateStore pin_state(TOTAL_MOTORS);
+// positions de départ reprises d'un arrêt normal (sinon estimation à confirmer par les capteurs)
+static bool positions_trusted = false;
+static SensorHealth tof_health(TOTAL_MOTORS, TOF_HEALTH);
+static SensorPoller tof_poller(TOTAL_MOTORS, TOF_INTERVAL_US, TOF_BUDGET_US);
+static SpeedModel speed_model(TOTAL_MOTORS, VMOY, VMAX, VITESSE_MM_S);
+static CurrentScheduler scheduler(TOTAL_MOTORS, MOTORS_PER_SUPPLY, SUPPLY_BUDGET_A, MOTOR_RUN_A, MOTOR_INRUSH_A,
+                                  VMOY, VMAX);
+static CurrentScheduler shadow_scheduler(TOTAL_MOTORS, MOTORS_PER_SUPPLY, SUPPLY_BUDGET_A, MOTOR_RUN_A,
+                                         MOTOR_INRUSH_A, VMOY, VMAX);
+static std::thread actuation_thread;
+static std::atomic<bool> actuation_running{false};
+// réception de la trame -> première commande qui en tient compte (EMA, ms)
+static std::atomic<float> command_latency_ms{0};
+static PwmBank pwm(PWM_BOARDS);
+static VL53L0X *tof[TOTAL_MOTORS];
+static Watchdog watchdog(WATCHDOG_PERIODS * 1000 / ACTUATION_HZ, []()
+                         {
+    fprintf(stderr, "[WATCHDOG] Boucle de commande bloquée, moteurs coupés\n");
+    pwm.force_stop(); });
 
 static void render_ui()
 {
+    // dernier état publié par la boucle d'actionnement
+    static ActuationState state = {};
+    actuation_state.fetch(state);
+
     printf("\e[H");
     printf("===== SHAPE DISPLAY SYSTEM =====\n");
-    printf("Config: %dx%d | Sol: %.0fmm | Seuil Max: %.0fmm\n", COLS, ROWS, DIST_SOL, DIST_OBJ_MAX);
+    printf("Config: %dx%d | Sol: %.0fmm | Seuil Max: %.0fmm | Positions initiales: %s\n", COLS, ROWS, DIST_SOL,
+           DIST_OBJ_MAX, positions_trusted ? "fiables" : "estimées");
     printf("------------------------------------------------------------\n");
 
     for (int i = 0; i < TOTAL_MOTORS; i++)
     {
         // Affichage : Index, Distance Kinect (mm), Position actuelle -> Cible (mm)
-        printf("M%d | Kinect: %4.0fmm | Pos: %4.1f -> %4.1fmm ",
-               i, moteurs[i].avg_depth_mm, moteurs[i].current_pos, moteurs[i].target_pos);
+        printf("M%d | Kinect: %4.0fmm (%3.0f%%) | Pos: %4.1f -> %4.1f -> %4.1fmm ",
+               i, moteurs[i].depth_mm, moteurs[i].valid_ratio * 100, state.position[i], state.setpoint[i],
+               moteurs[i].target_pos);
 
-        int bars = (int)(moteurs[i].current_pos / (COURSE_MAX / 15.0f));
+        int bars = (int)(state.position[i] / (COURSE_MAX / 15.0f));
         printf("|");
         for (int b = 0; b < 15; b++)
             printf(b < bars ? "#" : " ");
         printf("|\n");
     }
+    printf("Tuiles modifiées: %llu/%llu | Zones ignorées: %llu/%llu | Moteurs ignorés: %llu/%llu\n",
+           (unsigned long long)tiles.get_tiles_dirty(), (unsigned long long)tiles.get_tiles_checked(),
+           (unsigned long long)tiles.get_zones_skipped(), (unsigned long long)tiles.get_zones_checked(),
+           (unsigned long long)state.motors_skipped, (unsigned long long)(state.motors_planned + state.motors_skipped));
+    printf("Zones estimées: %llu | Scans complets: %llu\n", (unsigned long long)zones_sampled,
+           (unsigned long long)zones_scanned);
+    printf("Latence: %.1f ms mesurée + %.0f ms capteur | Actionnement: %.0f Hz\n", command_latency_ms.load(),
+           KINECT_TRANSPORT_MS, state.rate_hz);
+    printf("Transactions PWM: %llu | sans filtre: %llu | économisées: %lld\n",
+           (unsigned long long)state.pwm_transactions, (unsigned long long)state.unfiltered_transactions,
+           (long long)(state.unfiltered_transactions - state.pwm_transactions));
+    printf("Courant: pic %.2f/%.2f A | commandes différées: %llu | bridées: %llu\n", state.supply_peak_a,
+           SUPPLY_BUDGET_A, (unsigned long long)state.motors_deferred, (unsigned long long)state.motors_limited);
+    printf("VL53L0X: %llu mesures / %llu lectures | reportées: %llu", (unsigned long long)state.tof_readings,
+           (unsigned long long)state.tof_polls, (unsigned long long)state.tof_deferred);
+    for (int i = 0; i < TOTAL_MOTORS; i++)
+        if (tof[i] && !tof_health.usable(i))
+            printf(" | M%d en quarantaine", i);
+    printf("\e[K\n"); // efface la fin de ligne quand une quarantaine est levée
 }
 
-static void show_matrix_viewport(uint16_t *depth_buffer)
+static void show_matrix_viewport()
 {
-    printf("\n--- VUE KINECT (Distances en cm) ---\n");
-    int stepX = K_WIDTH / 40;
-    int stepY = K_HEIGHT / 20;
+    printf("\n--- VUE KINECT : ROI %dx%d, %zu octets/trame au lieu de %zu (Distances en cm) ---\n",
+           frame.get_width(), frame.get_height(), frame.bytes_per_frame(), DepthFrame::FULL_FRAME_BYTES);
+    // échantillonnage du buffer compact : au plus 32 colonnes et 16 lignes affichées
+    int stepX = std::max(1, (frame.get_width() + 31) / 32);
+    int stepY = std::max(1, (frame.get_height() + 15) / 16);
+    uint16_t const *data = frame.get_data();
 
-    for (int y = 2 * stepY; y < K_HEIGHT; y += stepY)
+    for (int y = 0; y < frame.get_height(); y += stepY)
     {
-        for (int x = 2 * stepX; x < K_WIDTH - 4 * stepX; x += stepX)
+        for (int x = 0; x < frame.get_width(); x += stepX)
         {
-            uint16_t d = depth_buffer[y * K_WIDTH + x];
+            uint16_t d = pixel_depth_mm(data[y * frame.get_width() + x]);
             if (d == 0)
                 printf("  . ");
             else if (d > 2500)
@@ -74,112 +339,727 @@ static void show_matrix_viewport(uint16_t *depth_buffer)
     }
 }
 
-static void process_kinect_logic(uint16_t *depth_buffer)
+// Incertitude sur la hauteur de pin, en mm, d'une estimation échantillonnée de la zone
+static float pin_bound_mm(int motor_idx, ZoneStats const &stats)
 {
-    for (int r = 0; r < ROWS; r++)
+    // pas encore de sol de référence (calibration) : scan complet
+    if (std::isinf(stats.bound) || reference_depth[motor_idx] <= DIST_OBJ_MAX)
+        return INFINITY;
+#if ZONE_ROBUST
+    // l'erreur type de la médiane vaut environ 1.25 fois celle de la moyenne
+    float center = stats.percentile, bound = stats.bound * 1.2533f;
+#else
+    float center = stats.mean, bound = stats.bound;
+#endif
+    // hauteur au-dessus du sol -> profondeur, de part et d'autre de l'estimation
+    float level = floor_level[motor_idx] - center;
+    float depth_bound = std::abs(zone_depth_mm(level + bound) - zone_depth_mm(std::max(level - bound, 0.0f))) / 2;
+    return depth_bound * COURSE_MAX / (reference_depth[motor_idx] - DIST_OBJ_MAX);
+}
+
+// temps monotone en µs
+static uint64_t now_us()
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000000 + ts.tv_nsec / 1000;
+}
+
+// Calcul du ratio de sortie du pin pour une profondeur de zone
+// On utilise reference_depth[motor_idx] au lieu de DIST_SOL
+static float target_for_depth(int motor_idx, float depth_mm)
+{
+    float diff_depth = reference_depth[motor_idx] - depth_mm;
+    float ratio = diff_depth / (reference_depth[motor_idx] - DIST_OBJ_MAX);
+    return std::clamp(ratio * COURSE_MAX, 0.0f, COURSE_MAX);
+}
+
+static void process_kinect_logic()
+{
+    tiles.update();
+    // hauteur au-dessus du sol de chaque pixel, lue par toutes les statistiques de zone
+    background.extract();
+    uint16_t const *heights = background.get_heights();
+    for (int motor_idx = 0; motor_idx < TOTAL_MOTORS; motor_idx++)
     {
-        for (int c = 0; c < COLS; c++)
+        // zone inchangée depuis la trame précédente : profondeur brute conservée
+        if (!tiles.changed(mapping.bounds(motor_idx)))
+            continue;
+
+        // Pixels du pin précalculés, toutes les statistiques en un passage
+        // estimation sur ZONE_SAMPLES pixels d'abord, table complète si elle est trop imprécise
+        ZoneStats stats = {};
+        bool sampled = false;
+        if (ZONE_SAMPLES > 0)
         {
-            int motor_idx = r * COLS + c;
-            long sum_depth = 0;
-            int samples = 0;
-            int centerX = c * ZONE_W + (ZONE_W / 2);
-            int centerY = r * ZONE_H + (ZONE_H / 2);
+            stats = zone_stats.estimate(heights, sample_patterns[motor_idx]);
+            sampled = pin_bound_mm(motor_idx, stats) <= ZONE_TOLERANCE_MM;
+        }
+        if (sampled)
+            zones_sampled++;
+        else
+        {
+            stats = zone_stats.gather(heights, mapping.pixels(motor_idx));
+            zones_scanned++;
+        }
+        moteurs[motor_idx].valid_ratio = stats.valid_ratio;
 
-            // Zone d'échantillonnage de 40x40 pixels
-            for (int y = centerY - 20; y < centerY + 20; y++)
-            {
-                for (int x = centerX - 20; x < centerX + 20; x++)
-                {
-                    if (x < 0 || x >= K_WIDTH || y < 0 || y >= K_HEIGHT)
-                        continue;
-                    uint16_t d = depth_buffer[y * K_WIDTH + x];
-                    if (d < 2400)
-                    { // Filtre les données aberrantes
-                        sum_depth += d;
-                        samples++;
-                    }
-                }
-            }
+        if (stats.valid_ratio >= ZONE_MIN_VALID)
+        {
+            // en mode brut, la statistique est faite en disparité et convertie une seule fois
+#if ZONE_ROBUST
+            float height = stats.percentile;
+#else
+            float height = stats.mean;
+#endif
+            raw_depth[motor_idx] = zone_depth_mm(std::max(floor_level[motor_idx] - height, 0.0f));
+        }
+        else
+        {
+            // Si trop peu de pixels valides sont trouvés, on stabilise à 0 (sol supposé)
+            raw_depth[motor_idx] = reference_depth[motor_idx];
+        }
+    }
 
-            if (samples > 0)
-            {
-                moteurs[motor_idx].avg_depth_mm = (float)sum_depth / samples;
+    // filtre temporel sur toutes les zones à la fois, au rythme des trames reçues
+    static uint64_t last_frame_us = 0;
+    uint64_t frame_us = frame.get_time_us();
+    float dt = last_frame_us && frame_us > last_frame_us ? (frame_us - last_frame_us) / 1e6f : 0;
+    last_frame_us = frame_us;
+    float filtered[TOTAL_MOTORS];
+    depth_filter.update(raw_depth, filtered, dt);
 
-                // Calcul du ratio de sortie du pin
-                // On utilise reference_depth[motor_idx] au lieu de DIST_SOL
-                float diff_depth = reference_depth[motor_idx] - moteurs[motor_idx].avg_depth_mm;
-                float ratio = diff_depth / (reference_depth[motor_idx] - DIST_OBJ_MAX);
-                moteurs[motor_idx].target_pos = std::clamp(ratio * COURSE_MAX, 0.0f, COURSE_MAX);
-            }
-            else
-            {
-                // Si aucun pixel valide n'est trouvé, on stabilise à 0 (sol supposé)
-                moteurs[motor_idx].avg_depth_mm = DIST_SOL;
-                moteurs[motor_idx].target_pos = 0;
-            }
+#if PREDICT_TARGETS
+    // la commande s'appliquera après le transport de la trame et le traitement mesuré ;
+    // la cible filtrée a en plus le retard du filtre temporel
+    float latency_ms = KINECT_TRANSPORT_MS + command_latency_ms;
+#endif
+
+    for (int motor_idx = 0; motor_idx < TOTAL_MOTORS; motor_idx++)
+    {
+        moteurs[motor_idx].depth_mm = filtered[motor_idx];
+        raw_target[motor_idx] = target_for_depth(motor_idx, raw_depth[motor_idx]);
+        float target = target_for_depth(motor_idx, filtered[motor_idx]);
+
+        // vitesse constante entre les deux dernières trames
+        if (dt > 0)
+            target_speed[motor_idx] = (target - last_target[motor_idx]) / dt;
+        last_target[motor_idx] = target;
+#if PREDICT_TARGETS
+        float horizon = std::min(latency_ms + depth_filter.group_delay(motor_idx, dt) * 1000.0f, PREDICTION_MAX_MS);
+        target = std::clamp(target + target_speed[motor_idx] * horizon / 1000.0f, 0.0f, COURSE_MAX);
+#endif
+        moteurs[motor_idx].target_pos = target;
+    }
+
+    // publication pour la boucle d'actionnement, qui interpole jusqu'à la trame suivante
+    TargetSet set;
+    for (int i = 0; i < TOTAL_MOTORS; i++)
+    {
+        set.target[i] = moteurs[i].target_pos;
+        set.unfiltered[i] = raw_target[i];
+    }
+    set.time_us = frame_us;
+    targets.publish(set);
+}
+
+// Temps écoulé dans le profil, nul si son début est encore à venir
+static uint32_t profile_elapsed(MotorState const &m, uint64_t t_us)
+{
+    int64_t elapsed = (int64_t)(t_us - m.profile_start_us);
+    return (uint32_t)std::clamp<int64_t>(elapsed, 0, UINT32_MAX);
+}
+
+// Tick de shadow_moteurs : même planification et même budget de courant que drive_motors, sur
+// la consigne non filtrée et une position seulement estimée (pas de recalage VL53L0X)
+// Renvoie vrai si une commande a changé, c'est-à-dire si drive_motors aurait écrit le PCA9685
+static bool drive_shadow(uint64_t t_us, float dt)
+{
+    int16_t duty[TOTAL_MOTORS], wanted[TOTAL_MOTORS];
+    float remaining_s[TOTAL_MOTORS];
+    bool running[TOTAL_MOTORS];
+    for (int i = 0; i < TOTAL_MOTORS; i++)
+    {
+        MotorState &m = shadow_moteurs[i];
+        bool moved = std::abs(m.setpoint - m.goal) > DEAD_BAND_MM;
+        bool missed = m.settled && std::abs(m.goal - m.current_pos) > DEAD_BAND_MM;
+        if (moved || missed)
+        {
+            m.goal = m.setpoint;
+            float distance = m.goal - m.current_pos;
+            if (std::abs(distance) <= DEAD_BAND_MM)
+                distance = 0;
+            float speed_per_duty = std::abs(speed_model.speed(i, distance < 0 ? -VMAX : VMAX)) / VMAX;
+            m.profile.plan(distance, m.duty, ACCEL_MM_S2, VMOY, VMAX, speed_per_duty, PROFILE_LEVELS);
+            m.profile_start_us = t_us;
+            m.settled = false;
+        }
+
+        running[i] = false;
+        if (m.settled)
+        {
+            duty[i] = wanted[i] = 0;
+            remaining_s[i] = 0;
+            continue;
         }
+        m.current_pos += speed_model.speed(i, m.duty) * dt;
+        uint32_t elapsed = profile_elapsed(m, t_us);
+        duty[i] = wanted[i] = m.profile.duty_at(elapsed);
+        remaining_s[i] = (m.profile.duration_us() - std::min(elapsed, m.profile.duration_us())) * 1e-6f;
+        running[i] = m.duty != 0 && (m.duty > 0) == (wanted[i] > 0);
     }
+
+    shadow_scheduler.schedule(duty, remaining_s, running);
+
+    bool changed = false;
+    for (int i = 0; i < TOTAL_MOTORS; i++)
+    {
+        MotorState &m = shadow_moteurs[i];
+        if (m.settled)
+            continue;
+        if (duty[i] == 0 && wanted[i] != 0)
+            m.profile_start_us = std::min(m.profile_start_us + (uint64_t)(dt * 1e6f), t_us);
+        changed |= duty[i] != m.duty;
+        m.duty = duty[i];
+        if (m.profile.finished(profile_elapsed(m, t_us)))
+            m.settled = true;
+    }
+    return changed;
 }
 
-static void drive_motors()
+// Un tick d'actionnement à t_us : dt en secondes depuis le tick précédent.
+// Chaque moteur suit un profil trapézoïdal, replanifié seulement quand la consigne sort de la
+// zone morte autour du but du profil ; le PCA9685 n'est écrit qu'aux changements de palier.
+static void drive_motors(uint64_t t_us, float dt)
 {
-    const float step = VITESSE_MM_S / 50.0f;
+    int16_t duty[TOTAL_MOTORS], wanted[TOTAL_MOTORS];
+    float remaining_s[TOTAL_MOTORS];
+    bool running[TOTAL_MOTORS];
     for (int i = 0; i < TOTAL_MOTORS; i++)
     {
-        float diff = moteurs[i].target_pos - moteurs[i].current_pos;
-        int chA = i * 2;
-        int chB = i * 2 + 1;
+        MotorState &m = moteurs[i];
 
-        if (std::abs(diff) > 1.2f)
+        // nouvelle consigne, ou arrivée loin du but (position recalée par le VL53L0X)
+        bool moved = std::abs(m.setpoint - m.goal) > DEAD_BAND_MM;
+        bool missed = m.settled && std::abs(m.goal - m.current_pos) > DEAD_BAND_MM;
+        if (moved || missed)
         {
-            int pwr = (std::abs(diff) > 10) ? VMAX : VMOY;
-            if (diff > 0)
+            m.goal = m.setpoint;
+            float distance = m.goal - m.current_pos;
+            if (std::abs(distance) <= DEAD_BAND_MM)
+                distance = 0;
+            // pente de la courbe apprise du moteur dans le sens du déplacement
+            float speed_per_duty = std::abs(speed_model.speed(i, distance < 0 ? -VMAX : VMAX)) / VMAX;
+            m.profile.plan(distance, m.duty, ACCEL_MM_S2, VMOY, VMAX, speed_per_duty, PROFILE_LEVELS);
+            m.profile_start_us = t_us;
+            m.settled = false;
+        }
+
+        running[i] = false;
+        if (m.settled)
+        {
+            actuation.motors_skipped++;
+            duty[i] = wanted[i] = 0;
+            remaining_s[i] = 0;
+            continue;
+        }
+        actuation.motors_planned++;
+
+        // position estimée avec la commande tenue depuis le tick précédent
+        m.current_pos += speed_model.speed(i, m.duty) * dt;
+
+        uint32_t elapsed = profile_elapsed(m, t_us);
+        duty[i] = wanted[i] = m.profile.duty_at(elapsed);
+        remaining_s[i] = (m.profile.duration_us() - std::min(elapsed, m.profile.duration_us())) * 1e-6f;
+        // un changement de sens repart de l'arrêt : appel de courant comme un démarrage
+        running[i] = m.duty != 0 && (m.duty > 0) == (wanted[i] > 0);
+    }
+
+    // budget de courant de chaque alimentation : commandes bridées ou différées
+    scheduler.schedule(duty, remaining_s, running);
+    actuation.motors_deferred = scheduler.get_deferred();
+    actuation.motors_limited = scheduler.get_limited();
+    actuation.supply_peak_a = scheduler.get_peak_a();
+
+    for (int i = 0; i < TOTAL_MOTORS; i++)
+    {
+        MotorState &m = moteurs[i];
+        if (m.settled)
+            continue;
+
+        // différé : le profil est suspendu, il reprendra là où il en était (jamais après t_us :
+        // un profil planifié à ce tick n'a encore rien à rattraper)
+        // bridé : le moteur prend du retard, rattrapé par une replanification à la fin du profil
+        if (duty[i] == 0 && wanted[i] != 0)
+            m.profile_start_us = std::min(m.profile_start_us + (uint64_t)(dt * 1e6f), t_us);
+        uint32_t elapsed = profile_elapsed(m, t_us);
+        if (m.duty && !duty[i])
+            m.stopped_us = t_us;
+        m.duty = duty[i];
+        if (m.duty > 0)
+            pwm.set_motor(i, m.duty, VOFF);
+        else if (m.duty < 0)
+            pwm.set_motor(i, VOFF, -m.duty);
+        else
+            pwm.stop_motor(i);
+        if (m.profile.finished(elapsed))
+            m.settled = true;
+    }
+    // même tick sans le filtre : transaction qu'il aurait coûté
+    actuation.unfiltered_transactions += drive_shadow(t_us, dt);
+    // une seule transaction pour toutes les cartes, seulement si une commande a changé
+    uint64_t before = pwm.get_transactions();
+    pwm.flush();
+    actuation.pwm_transactions += pwm.get_transactions() - before;
+    watchdog.heartbeat();
+}
+
+// Position mesurée par le VL53L0X du moteur i, si une mesure est prête
+// À commande constante, l'écart entre deux mesures espacées d'au moins SPEED_WINDOW_MS
+// corrige la courbe de vitesse du moteur. Renvoie vrai si le capteur avait une mesure prête
+// Chaque interrogation est transmise au suivi de santé du capteur
+static bool read_tof(int i, uint64_t t_us)
+{
+    uint16_t range;
+    uint8_t status;
+    MotorState &m = moteurs[i];
+    if (!tof[i]->readRangeIfReady(&range, &status))
+    {
+        tof_health.record(i, t_us, tof[i]->timeoutOccurred() ? SENSOR_ERROR : SENSOR_PENDING);
+        return false;
+    }
+    bool valid = status == VL53L0X::RANGE_STATUS_VALID && range < 8190;
+    float measured = std::clamp((float)TOF[i].zero_mm - range, 0.0f, COURSE_MAX);
+    // en butée le pin ne bouge plus quelle que soit la commande : ni mesure de vitesse,
+    // ni capteur figé à soupçonner
+    bool free = valid && measured > DEAD_BAND_MM && measured < COURSE_MAX - DEAD_BAND_MM;
+    tof_health.record(i, t_us, valid ? SENSOR_VALID : SENSOR_INVALID, range, m.duty != 0 && free);
+    if (!valid)
+        return true;
+    m.current_pos += TOF_GAIN * (measured - m.current_pos);
+
+    if (m.duty != m.window_duty || !free)
+    {
+        m.window_duty = free ? m.duty : 0;
+        m.window_pos = measured;
+        m.window_us = t_us;
+        return true;
+    }
+    if (t_us - m.window_us < SPEED_WINDOW_MS * 1000ull)
+        return true;
+    if (m.duty != 0)
+        speed_model.observe(i, m.duty, (measured - m.window_pos) / ((t_us - m.window_us) / 1e6f), SPEED_LEARN_GAIN);
+    m.window_pos = measured;
+    m.window_us = t_us;
+    return true;
+}
+
+// Reprise d'un capteur en quarantaine (thread de SensorHealth) : réinitialisation complète
+// et nouvelle calibration, la boucle ne l'interroge plus pendant ce temps
+static bool recover_tof(int i)
+{
+    tof[i]->stopContinuous();
+    if (!tof[i]->init(true, VL53L0X_CALIBRATION_FILE, true))
+        return false;
+    tof[i]->startContinuous();
+    return true;
+}
+
+// Lecture des VL53L0X dus ce tick, les pins en mouvement d'abord, dans le budget i2c
+static void poll_tof(uint64_t t_us)
+{
+    SensorActivity activity[TOTAL_MOTORS];
+    for (int i = 0; i < TOTAL_MOTORS; i++)
+    {
+        MotorState const &m = moteurs[i];
+        // capteur en quarantaine : position estimée seulement, jusqu'à sa reprise
+        if (!tof[i] || !tof_health.usable(i))
+            activity[i] = SENSOR_NONE;
+        else if (m.duty)
+            activity[i] = SENSOR_MOVING;
+        else if (t_us - m.stopped_us < TOF_SETTLE_MS * 1000ull)
+            activity[i] = SENSOR_SETTLING;
+        else
+            activity[i] = SENSOR_IDLE;
+    }
+
+    int order[TOTAL_MOTORS];
+    int n = tof_poller.schedule(t_us, activity, order);
+    for (int k = 0; k < n; k++)
+    {
+        uint64_t before = now_us();
+        bool measured = read_tof(order[k], t_us);
+        tof_poller.done(order[k], t_us, now_us() - before, measured);
+    }
+    actuation.tof_polls = tof_poller.get_polls();
+    actuation.tof_readings = tof_poller.get_readings();
+    actuation.tof_deferred = tof_poller.get_deferred();
+}
+
+// Boucle d'actionnement à ACTUATION_HZ : interpole les cibles de la vision entre deux
+// trames, recale les positions sur les VL53L0X et envoie les commandes
+static void actuation_loop()
+{
+    const uint64_t period_ns = 1000000000ull / ACTUATION_HZ;
+    TargetSet set = {};
+    float from[TOTAL_MOTORS], unfiltered[TOTAL_MOTORS], shadow_from[TOTAL_MOTORS];
+    for (int i = 0; i < TOTAL_MOTORS; i++)
+    {
+        shadow_moteurs[i] = moteurs[i];
+        from[i] = unfiltered[i] = shadow_from[i] = moteurs[i].setpoint;
+    }
+    uint64_t ramp_start_us = 0, ramp_us = LOOP_PERIOD_MS * 1000, last_frame_us = 0;
+    bool received = false;
+
+    struct timespec next;
+    clock_gettime(CLOCK_MONOTONIC, &next);
+    uint64_t last_us = now_us(), checkpoint_us = last_us;
+
+    while (actuation_running)
+    {
+        uint64_t t = now_us();
+        float dt = (t - last_us) / 1e6f;
+        last_us = t;
+
+        TargetSet fresh;
+        bool new_targets = targets.fetch(fresh);
+        if (new_targets)
+        {
+            // rampe de la consigne courante vers la nouvelle cible sur un intervalle de trames
+            if (received && fresh.time_us > last_frame_us)
+                ramp_us = std::clamp<uint64_t>(fresh.time_us - last_frame_us, 5000, 100000);
+            last_frame_us = fresh.time_us;
+            for (int i = 0; i < TOTAL_MOTORS; i++)
             {
-                pca.set_pwm(chA, pwr);
-                pca.set_pwm(chB, VOFF);
-                moteurs[i].current_pos += step;
+                from[i] = moteurs[i].setpoint;
+                shadow_from[i] = shadow_moteurs[i].setpoint;
             }
-            else
+            std::copy(std::begin(fresh.unfiltered), std::end(fresh.unfiltered), unfiltered);
+            set = fresh;
+            ramp_start_us = t;
+            received = true;
+        }
+
+        poll_tof(t);
+
+        // vision muette : les moteurs s'arrêtent là où ils sont
+        bool stale = !received || t - last_frame_us > VISION_TIMEOUT_MS * 1000ull;
+        float a = std::min(1.0f, (float)(t - ramp_start_us) / ramp_us);
+        for (int i = 0; i < TOTAL_MOTORS; i++)
+        {
+            moteurs[i].setpoint = stale ? moteurs[i].current_pos : from[i] + a * (set.target[i] - from[i]);
+            shadow_moteurs[i].setpoint = stale ? shadow_moteurs[i].current_pos
+                                               : shadow_from[i] + a * (unfiltered[i] - shadow_from[i]);
+        }
+
+        // après un arrêt d'urgence les moteurs restent coupés
+        if (!Test::should_exit)
+        {
+            drive_motors(t, dt);
+            if (new_targets)
             {
-                pca.set_pwm(chA, VOFF);
-                pca.set_pwm(chB, pwr);
-                moteurs[i].current_pos -= step;
+                float latency_ms = (now_us() - fresh.time_us) / 1000.0f;
+                command_latency_ms = command_latency_ms + 0.1f * (latency_ms - command_latency_ms);
             }
         }
         else
+            watchdog.heartbeat(); // boucle vivante, moteurs coupés : pas un blocage
+
+        for (int i = 0; i < TOTAL_MOTORS; i++)
         {
-            pca.set_pwm(chA, 0);
-            pca.set_pwm(chB, 0);
+            actuation.position[i] = moteurs[i].current_pos;
+            actuation.setpoint[i] = moteurs[i].setpoint;
         }
+        if (t - checkpoint_us >= STATE_CHECKPOINT_MS * 1000ull)
+        {
+            pin_state.checkpoint(actuation.position, false);
+            checkpoint_us = t;
+        }
+        if (dt > 0)
+            actuation.rate_hz += 0.01f * (1.0f / dt - actuation.rate_hz);
+        actuation_state.publish(actuation);
+
+        // période fixe : réveil à une échéance absolue, sans dérive
+        next.tv_nsec += period_ns;
+        if (next.tv_nsec >= 1000000000)
+        {
+            next.tv_sec++;
+            next.tv_nsec -= 1000000000;
+        }
+        clock_nanosleep(CLOCK_MONOTONIC, TIMER_ABSTIME, &next, nullptr);
     }
 }
 
-static void reset_pins_to_8mm()
+// Résultat d'un retour en position, par pin : durée et condition d'arrêt
+struct HomingReport
 {
-    printf("\n[RESET] Positionnement des pins à 8mm...\n");
+    bool ran = false;
+    float seconds[TOTAL_MOTORS];
+    const char *how[TOTAL_MOTORS];
+};
+static HomingReport startup_homing;
 
-    // 1. Définir la cible à OFFSETmm pour tous les moteurs
+static void print_homing(HomingReport const &report)
+{
+    if (!report.ran)
+        return;
+    float total = 0;
     for (int i = 0; i < TOTAL_MOTORS; i++)
     {
-        moteurs[i].target_pos = OFFSET;
+        printf("[HOMING] M%d : %.2f s (%s)\n", i, report.seconds[i], report.how[i]);
+        total = std::max(total, report.seconds[i]);
     }
+    printf("[HOMING] Tous les pins en position en %.2f s\n", total);
+}
+
+/**
+ * Ramène tous les pins à OFFSET en même temps, hors de la boucle d'actionnement (arrêtée)
+ * Pin avec VL53L0X : conduit vers OFFSET d'après ses mesures, arrêté dès qu'il y reste
+ * HOMING_SETTLE_MS ou s'il cale. Pin sans capteur : descente en butée basse pendant le temps
+ * calculé sur sa courbe de vitesse (toute la course si sa position n'est pas fiable),
+ * puis remontée chronométrée jusqu'à OFFSET. Un capteur muet pendant HOMING_STALL_MS (aucune
+ * mesure valide) fait repartir son pin comme s'il n'en avait pas, depuis toute la course.
+ * Les commandes passent par le budget de courant comme celles des profils ; un pin différé
+ * ou bridé voit sa minuterie allongée d'autant.
+ * Retour en position explicite : lève le verrou d'urgence. Interrompu par un nouvel arrêt
+ * d'urgence ou une demande d'arrêt survenue pendant le retour.
+ * @return faux si interrompu ou si un pin s'est arrêté sur le délai (positions non fiables)
+ */
+static bool home_pins(HomingReport &report)
+{
+    const uint64_t period_ns = 1000000000ull / ACTUATION_HZ;
+    // appelé pour garer les pins à l'arrêt : la demande d'arrêt est déjà là
+    const bool exiting = Test::should_exit;
+    PCA9685::clear_emergency();
+    // durée d'un mouvement chronométré, bornée par le délai de sécurité
+    auto timed_us = [](float mm, float speed)
+    { return (uint64_t)(std::min(mm / std::abs(speed), HOMING_TIMEOUT_MS / 1000.0f) * 1e6f); };
+    struct PinHoming
+    {
+        bool done = false;
+        int16_t duty = 0;
+        uint64_t phase_end_us = 0; // sans capteur : fin de la descente puis de la remontée
+        bool rising = false;
+        bool seen = false; // au moins une mesure
+        uint64_t valid_us = 0; // dernière mesure valide (départ du retour avant la première)
+        bool muted = false;    // capteur muet : passé sur le chemin chronométré
+        float window_pos = 0; // calage : position au début de la fenêtre
+        uint64_t window_us = 0;
+        uint64_t settle_us = 0; // entrée dans la bande autour de la cible (0 : dehors)
+        int16_t applied = 0; // commande envoyée après arbitrage du courant
+    } pins[TOTAL_MOTORS];
 
-    // 2. Faire tourner la boucle de mouvement pendant un court instant
-    // On simule environ 3 secondes de mouvement pour être sûr d'atteindre la position
-    for (int i = 0; i < 150; i++)
+    // capteurs en quarantaine : leurs pins reviennent comme s'ils n'en avaient pas
+    bool sensor[TOTAL_MOTORS];
+    uint64_t start = now_us();
+    for (int i = 0; i < TOTAL_MOTORS; i++)
     {
-        drive_motors();
-        usleep(40000); // 20ms comme dans le main
+        report.how[i] = "délai";
+        sensor[i] = tof[i] && tof_health.usable(i);
+        pins[i].valid_us = start;
+        if (sensor[i])
+            continue;
+        // descente en butée : la position de départ n'est qu'une borne
+        float from = positions_trusted ? moteurs[i].current_pos : COURSE_MAX;
+        pins[i].duty = -VMAX;
+        pins[i].phase_end_us = start + timed_us(from + HOMING_MARGIN_MM, speed_model.speed(i, -VMAX));
     }
 
-    // 3. Tout couper
-    printf("[RESET] Extinction des moteurs.\n");
-    for (int i = 0; i < 16; i++)
+    struct timespec next;
+    clock_gettime(CLOCK_MONOTONIC, &next);
+    int remaining = TOTAL_MOTORS;
+    bool aborted = false, timed_out = false;
+    while (remaining > 0)
     {
-        pca.set_pwm(i, 0);
+        if (PCA9685::emergency_latched() || (Test::should_exit && !exiting))
+        {
+            aborted = true;
+            break;
+        }
+        uint64_t t = now_us();
+        bool timeout = t - start > HOMING_TIMEOUT_MS * 1000ull;
+        int16_t duty[TOTAL_MOTORS];
+        float remaining_s[TOTAL_MOTORS];
+        bool running[TOTAL_MOTORS];
+        for (int i = 0; i < TOTAL_MOTORS; i++)
+        {
+            PinHoming &h = pins[i];
+            if (h.done)
+                continue;
+            const char *how = nullptr;
+            if (!sensor[i])
+            {
+                if (t >= h.phase_end_us && !h.rising && OFFSET > 0)
+                {
+                    // en butée basse, position connue : remontée chronométrée
+                    h.rising = true;
+                    h.duty = VMOY;
+                    h.phase_end_us = t + timed_us(OFFSET, speed_model.speed(i, VMOY));
+                }
+                else if (t >= h.phase_end_us)
+                {
+                    moteurs[i].current_pos = OFFSET;
+                    how = h.muted ? "minuterie, capteur muet" : "minuterie";
+                }
+            }
+            else if (t - h.valid_us >= HOMING_STALL_MS * 1000ull)
+            {
+                // aucune mesure valide : pin conduit à l'aveugle, repli sur le chemin sans capteur
+                // depuis toute la course (la dernière mesure a vieilli d'autant)
+                sensor[i] = false;
+                h.muted = true;
+                h.rising = false;
+                h.duty = -VMAX;
+                h.phase_end_us = t + timed_us(COURSE_MAX + HOMING_MARGIN_MM, speed_model.speed(i, -VMAX));
+            }
+            else
+            {
+                uint16_t range;
+                uint8_t status;
+                if (tof[i]->readRangeIfReady(&range, &status) && status == VL53L0X::RANGE_STATUS_VALID &&
+                    range < 8190)
+                {
+                    float measured = std::clamp((float)TOF[i].zero_mm - range, 0.0f, COURSE_MAX);
+                    moteurs[i].current_pos = measured;
+                    h.valid_us = t;
+                    float error = OFFSET - measured;
+                    int16_t duty = 0;
+                    if (std::abs(error) <= DEAD_BAND_MM)
+                    {
+                        if (!h.settle_us)
+                            h.settle_us = t;
+                        else if (t - h.settle_us >= HOMING_SETTLE_MS * 1000ull)
+                            how = "capteur";
+                    }
+                    else
+                    {
+                        h.settle_us = 0;
+                        duty = std::abs(error) > HOMING_SLOW_MM ? VMAX : VMOY;
+                        duty = error > 0 ? duty : -duty;
+                    }
+
+                    // calage : commandé mais immobile (butée, pin bloqué)
+                    if (duty != h.duty || !h.seen)
+                    {
+                        h.window_pos = measured;
+                        h.window_us = t;
+                    }
+                    else if (duty && t - h.window_us >= HOMING_STALL_MS * 1000ull)
+                    {
+                        if (std::abs(measured - h.window_pos) < HOMING_STALL_MM)
+                            how = "calage";
+                        h.window_pos = measured;
+                        h.window_us = t;
+                    }
+                    h.duty = duty;
+                    h.seen = true;
+                }
+            }
+            if (!how && timeout)
+            {
+                how = "délai";
+                timed_out = true;
+            }
+            if (how)
+            {
+                h.done = true;
+                h.duty = 0;
+                report.how[i] = how;
+                report.seconds[i] = (t - start) / 1e6f;
+                remaining--;
+            }
+
+            duty[i] = h.duty;
+            running[i] = h.applied != 0 && (h.applied > 0) == (h.duty > 0);
+            if (!h.duty)
+                remaining_s[i] = 0;
+            else if (!sensor[i])
+                remaining_s[i] = (h.phase_end_us - std::min(t, h.phase_end_us)) / 1e6f;
+            else
+                remaining_s[i] = std::abs(OFFSET - moteurs[i].current_pos) / std::abs(speed_model.speed(i, h.duty));
+        }
+
+        // même budget de courant que la boucle d'actionnement : pas tous les pins à VMAX d'un coup
+        scheduler.schedule(duty, remaining_s, running);
+        for (int i = 0; i < TOTAL_MOTORS; i++)
+        {
+            PinHoming &h = pins[i];
+            if (duty[i] != h.duty)
+            {
+                // différé ou bridé : la minuterie rattrape la course non faite pendant ce tick,
+                // le calage ne compte pas un pin que l'arbitrage a retenu
+                if (!sensor[i])
+                    h.phase_end_us += (uint64_t)(period_ns / 1000 *
+                                                 (1 - speed_model.speed(i, duty[i]) / speed_model.speed(i, h.duty)));
+                h.window_pos = moteurs[i].current_pos;
+                h.window_us = t;
+            }
+            h.applied = duty[i];
+            if (duty[i] > 0)
+                pwm.set_motor(i, duty[i], VOFF);
+            else if (duty[i] < 0)
+                pwm.set_motor(i, VOFF, -duty[i]);
+            else
+                pwm.stop_motor(i);
+        }
+        pwm.flush();
+        watchdog.heartbeat();
+
+        next.tv_nsec += period_ns;
+        if (next.tv_nsec >= 1000000000)
+        {
+            next.tv_sec++;
+            next.tv_nsec -= 1000000000;
+        }
+        clock_nanosleep(CLOCK_MONOTONIC, TIMER_ABSTIME, &next, nullptr);
+    }
+
+    for (int i = 0; i < TOTAL_MOTORS; i++)
+    {
+        MotorState &m = moteurs[i];
+        m.setpoint = m.goal = m.current_pos;
+        m.duty = 0;
+        m.settled = true;
+    }
+    if (aborted)
+    {
+        for (int i = 0; i < TOTAL_MOTORS; i++)
+            pwm.stop_motor(i);
+        pwm.flush();
+        printf("[HOMING] Interrompu, positions non fiables\n");
+        return false;
+    }
+    report.ran = true;
+    print_homing(report);
+    if (timed_out)
+        printf("[HOMING] Pins arrêtés sur le délai, positions non fiables\n");
+    return !timed_out;
+}
+
+// Arrête la boucle d'actionnement et coupe les moteurs (après retour à OFFSET si park),
+// puis enregistre les positions, fiables pour le prochain démarrage sauf retour interrompu
+static void stop_actuation(bool park)
+{
+    actuation_running = false;
+    if (actuation_thread.joinable())
+        actuation_thread.join();
+    bool trusted = true;
+    if (park)
+    {
+        printf("\n[RESET] Positionnement des pins à %dmm...\n", OFFSET);
+        HomingReport report;
+        trusted = home_pins(report);
     }
+    watchdog.stop();
+    printf("[RESET] Extinction des moteurs.\n");
+    pwm.all_stop();
+
+    float positions[TOTAL_MOTORS];
+    for (int i = 0; i < TOTAL_MOTORS; i++)
+        positions[i] = moteurs[i].current_pos;
+    pin_state.checkpoint(positions, trusted, true);
 }
+
 static void calibrate_ground()
 {
     printf("[CALIBRATION] Mesure du sol en cours... Ne rien mettre sous la Kinect.\n");
@@ -189,17 +1069,37 @@ static void calibrate_ground()
     // On ignore les premières trames pour laisser le capteur se stabiliser
     for (int i = 0; i < 30; i++)
     {
-        freenect_sync_get_depth((void **)&depth_buffer, &timestamp, 0, FREENECT_DEPTH_MM);
+        freenect_sync_get_depth((void **)&depth_buffer, &timestamp, 0, DEPTH_FORMAT);
+        usleep(30000);
+    }
+
+    // Modèle du sol pixel par pixel sur BACKGROUND_FRAMES trames
+    background.reset();
+    for (int i = 0; i < BACKGROUND_FRAMES; i++)
+    {
+        if (freenect_sync_get_depth((void **)&depth_buffer, &timestamp, 0, DEPTH_FORMAT) == 0)
+        {
+            frame.capture(depth_buffer, timestamp);
+            background.accumulate();
+        }
         usleep(30000);
     }
+    background.finish();
+    printf("  Fond : %.0f%% des pixels, bruit moyen %.2f\n", background.get_coverage() * 100, background.get_noise());
 
-    // On calcule la moyenne du sol pour chaque moteur
-    process_kinect_logic(depth_buffer);
+    // Sol de chaque moteur : moyenne pondérée du fond sur les pixels du pin
+    ZoneStatistics floor_stats(DEPTH_VALID_MAX, 50);
     for (int i = 0; i < TOTAL_MOTORS; i++)
     {
-        reference_depth[i] = moteurs[i].avg_depth_mm;
+        ZoneStats stats = floor_stats.gather(background.get_background(), mapping.pixels(i));
+        floor_level[i] = stats.valid_ratio > 0 ? stats.mean : depth_level(DIST_SOL);
+        reference_depth[i] = zone_depth_mm(floor_level[i]);
         printf("  M%d : Sol détecté à %.0f mm\n", i, reference_depth[i]);
     }
+    // toutes les zones sont recalculées sur la première trame, sans historique de filtre ni vitesse
+    tiles.invalidate();
+    depth_filter.reset();
+    std::fill(std::begin(target_speed), std::end(target_speed), 0.0f);
     printf("[CALIBRATION] Terminée.\n");
 }
 
@@ -211,29 +1111,117 @@ int main(int argc, char **argv)
         return test_instance.run();
     }
     // Par défaut, exécution complete
+    signal(SIGINT, signal_handler);
+
+    // sans calibration, la disposition par défaut sert de modèle à corriger
+    if (access(PIN_MAPPING_FILE, F_OK) != 0)
+        mapping.save(PIN_MAPPING_FILE);
+    printf("[MAPPING] Homographie grille -> Kinect, erreur %.2f px\n", mapping.get_error());
+    mapping.build(frame, PIN_TENT_WEIGHTS);
+    for (int i = 0; i < TOTAL_MOTORS; i++)
+        sample_patterns[i] = mapping.sample(frame, i, ZONE_SAMPLES);
+    if (speed_model.load(SPEED_MODEL_FILE))
+        printf("[VITESSE] Courbes des moteurs lues dans %s\n", SPEED_MODEL_FILE);
+
+    // reprise des positions du dernier arrêt au lieu de supposer les pins à OFFSET
+    float saved[TOTAL_MOTORS];
+    if (pin_state.open(PIN_STATE_FILE) && pin_state.resume(saved, positions_trusted))
+    {
+        for (int i = 0; i < TOTAL_MOTORS; i++)
+            moteurs[i].current_pos = moteurs[i].setpoint = moteurs[i].goal = saved[i];
+        printf("[ETAT] Positions reprises de %s (%s)\n", PIN_STATE_FILE,
+               positions_trusted ? "arrêt normal" : "arrêt interrompu, à confirmer");
+    }
+    // tant que le programme tourne, la sauvegarde ne vaut qu'estimation
+    for (int i = 0; i < TOTAL_MOTORS; i++)
+        saved[i] = moteurs[i].current_pos;
+    pin_state.checkpoint(saved, false, true);
     uint16_t *depth_buffer = NULL;
     uint32_t timestamp;
 
-    pca = PCA9685(0x40);
-    if (!pca.init())
+    // Kinect, PCA9685 et capteurs démarrent en parallèle
+    Startup startup;
+    bool pwm_ok = false;
+    startup.add("kinect", []()
+                { calibrate_ground(); return true; });
+    startup.add("pca9685", [&pwm_ok]()
+                { return pwm_ok = pwm.init(); });
+    for (int i = 0; i < TOTAL_MOTORS; i++)
+    {
+        if (!TOF[i].addr)
+            continue;
+        // sans zero_mm toutes les mesures seraient ramenées à 0 et tireraient la position vers 0
+        if (!TOF[i].zero_mm)
+        {
+            fprintf(stderr, "[VL53L0X] M%d : zero_mm non renseigné, capteur ignoré\n", i);
+            continue;
+        }
+        tof[i] = new VL53L0X(TOF[i].addr, TOF[i].bus ? TOF[i].bus : I2C_DEVICE);
+        startup.add("vl53l0x M" + std::to_string(i), [i]()
+                    {
+            if (tof[i]->init(true, VL53L0X_CALIBRATION_FILE))
+            {
+                // mesures enchaînées, relevées sans attente par la boucle d'actionnement
+                tof[i]->startContinuous();
+                return true;
+            }
+            // capteur absent ou en défaut : le moteur fonctionnera sans
+            delete tof[i];
+            tof[i] = nullptr;
+            return false; });
+    }
+    // un thread par bus : les commandes moteur passent avant les lectures capteurs
+    I2C_bus::start_all();
+    startup.run();
+    if (!pwm_ok)
+    {
+        // aucun moteur n'a tourné : la sauvegarde garde sa fiabilité
+        pin_state.checkpoint(saved, positions_trusted, true);
+        startup.print_timeline();
         return 1;
-    calibrate_ground();
+    }
 
+    // capteurs défaillants réinitialisés en arrière-plan pendant que la boucle continue
+    tof_health.start(recover_tof);
+    watchdog.start();
+    // positions d'un arrêt interrompu : retour en référence avant de suivre la vision
+    if (!positions_trusted && !Test::should_exit)
+        positions_trusted = home_pins(startup_homing);
     printf("\e[2J");
+    actuation_running = true;
+    actuation_thread = std::thread(actuation_loop);
 
     while (!Test::should_exit)
     {
-        if (freenect_sync_get_depth((void **)&depth_buffer, &timestamp, 0, FREENECT_DEPTH_MM) == 0)
+        if (freenect_sync_get_depth((void **)&depth_buffer, &timestamp, 0, DEPTH_FORMAT) == 0)
         {
-            process_kinect_logic(depth_buffer);
-            drive_motors();
-
+            // la vision suit le rythme de la Kinect, l'actionnement tourne à part
+            frame.capture(depth_buffer, timestamp);
+            process_kinect_logic();
             render_ui();
-            show_matrix_viewport(depth_buffer);
+            show_matrix_viewport();
         }
-        usleep(20000);
+        else
+            usleep(20000);
     }
+    long latency_us = PCA9685::emergency_latency_us();
+    if (latency_us >= 0)
+        printf("\n[ARRET] Moteurs coupés en %ld us après le signal\n", latency_us);
     freenect_sync_stop();
-    reset_pins_to_8mm();
+    // l'écran est rafraîchi en boucle pendant l'exécution, on affiche la chronologie à la fin
+    startup.print_timeline();
+    stop_actuation(PARK_ON_EXIT);
+    tof_health.stop();
+    I2C_bus::print_stats_all();
+    watchdog.print_stats();
+    tof_health.print_stats();
+    print_homing(startup_homing);
+    tiles.print_stats();
+    printf("===== FILTRE DE ZONE =====\ntransactions PWM %llu, %llu sans filtre\n",
+           (unsigned long long)actuation.pwm_transactions, (unsigned long long)actuation.unfiltered_transactions);
+    // courbes corrigées par les VL53L0X : reprises au prochain démarrage
+    if (speed_model.get_samples() && speed_model.save(SPEED_MODEL_FILE))
+        printf("[VITESSE] %llu mesures, courbes enregistrées dans %s\n",
+               (unsigned long long)speed_model.get_samples(), SPEED_MODEL_FILE);
     return 0;
 }
\ No newline at end of file
@@ -0,0 +1,77 @@
+#include "motion_profile.hpp"
+#include <algorithm>
+#include <cmath>
+
+void TrapezoidProfile::add(float t_s, int16_t duty)
+{
+    // paliers de durée nulle ou répétés : pas de changement de commande
+    uint32_t t_us = (uint32_t)std::lround(t_s * 1e6f);
+    if (count && steps[count - 1].duty == duty)
+        return;
+    if (count && steps[count - 1].t_us == t_us)
+        count--;
+    steps[count++] = {t_us, duty};
+}
+
+void TrapezoidProfile::plan(float distance, int16_t start_duty, float accel, uint16_t duty_min, uint16_t duty_max,
+                            float speed_per_duty, int levels)
+{
+    count = 0;
+    float d = std::abs(distance);
+    if (d <= 0 || speed_per_duty <= 0 || accel <= 0 || duty_min == 0)
+        return;
+    int sign = distance < 0 ? -1 : 1;
+    levels = std::clamp(levels, 1, MAX_LEVELS);
+    duty_max = std::max(duty_max, duty_min);
+
+    // palier k : rapport cyclique et vitesse ; dt : temps pour passer d'un palier au suivant
+    auto duty = [&](int k)
+    { return (int16_t)(sign * (duty_min + (duty_max - duty_min) * k / levels)); };
+    auto speed = [&](int k)
+    { return std::abs(duty(k)) * speed_per_duty; };
+    float dt = (duty_max - duty_min) * speed_per_duty / (accel * levels);
+
+    // palier de départ : celui du moteur s'il tourne déjà dans ce sens
+    int ks = 0;
+    if (start_duty * sign > duty_min)
+        ks = std::min(levels, (int)std::lround((float)(start_duty * sign - duty_min) * levels / std::max(duty_max - duty_min, 1)));
+
+    // distance parcourue en montant de ks à kp puis en redescendant de kp au palier 0
+    auto ramps = [&](int kp)
+    {
+        float sum = 0;
+        for (int k = ks; k < kp; k++)
+            sum += speed(k) * dt;
+        for (int k = 0; k < kp; k++)
+            sum += speed(k) * dt;
+        return sum;
+    };
+
+    // plus haut palier atteignable sans dépasser la distance
+    int kp = ks;
+    while (kp < levels && ramps(kp + 1) <= d)
+        kp++;
+    float ramp = ramps(kp);
+    float scale = 1, cruise = 0;
+    if (ramp > d)
+        scale = d / ramp; // déjà trop lancé : décélération raccourcie
+    else
+        cruise = (d - ramp) / speed(kp);
+
+    float t = 0;
+    for (int k = ks; k < kp; k++, t += dt)
+        add(t, duty(k));
+    add(t, duty(kp));
+    t += cruise;
+    for (int k = kp - 1; k >= 0; k--, t += dt * scale)
+        add(t, duty(k));
+    add(t, 0);
+}
+
+int16_t TrapezoidProfile::duty_at(uint32_t t_us) const
+{
+    int16_t duty = 0;
+    for (int i = 0; i < count && steps[i].t_us <= t_us; i++)
+        duty = steps[i].duty;
+    return duty;
+}
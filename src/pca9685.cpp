@@ -2,7 +2,12 @@
 #include <unistd.h>
 #include <cmath>
 
-PCA9685::PCA9685(uint8_t address) : I2C_slave(address)
+int PCA9685::emergency_fd = -1;
+uint8_t PCA9685::emergency_buf[5] = {ALL_LED_ON_L, 0x00, 0x00, 0x00, FULL_OFF};
+struct i2c_msg PCA9685::emergency_msg;
+struct timespec PCA9685::emergency_start, PCA9685::emergency_end;
+
+PCA9685::PCA9685(uint8_t address, const char *bus_path) : I2C_slave(address, I2C_PRIO_ACTUATION, bus_path)
 {
 }
 
@@ -19,8 +24,8 @@ bool PCA9685::init()
     if (!reset())
         return false;
 
-    // Configure MODE1 : AI=1 (auto-increment), SLEEP=0 (mode normal)
-    if (!write(MODE1, (uint8_t)0x20)) // Bit AI = bit 5
+    // Configure MODE1 : AI=1 (auto-increment), SLEEP=0 (mode normal), ALLCALL=1 (répond à l'adresse commune)
+    if (!write(MODE1, MODE1_DEFAULT)) // Bit AI = bit 5, ALLCALL = bit 0
         return false;
 
     // Configure MODE2 : OUTDRV=1 (totem pole, pas open-drain)
@@ -43,16 +48,32 @@ bool PCA9685::set_frequency(uint16_t frequency)
     if (frequency < 24 || frequency > 1526)
         return false;
 
-    // Calcule la valeur du prescaler
-    // Oscillateur interne = 25 MHz
-    float prescale_val = 25000000.0f / (4096.0f * frequency) - 1.0f;
-    uint8_t prescale = (uint8_t)round(prescale_val);
-
     // Lit le MODE1 actuel
     uint8_t old_mode;
     if (!read(MODE1, &old_mode))
         return false;
 
+    return set_frequency(frequency, old_mode);
+}
+
+/**
+ * Définit la fréquence PWM sans relire MODE1
+ * Utilisé sur l'adresse ALL_CALL, où toutes les cartes reçoivent l'écriture mais
+ * où une lecture n'a pas de sens
+ * @param frequency Fréquence désirée en Hz
+ * @param old_mode Valeur actuelle de MODE1
+ * @return true si succès, false sinon
+ */
+bool PCA9685::set_frequency(uint16_t frequency, uint8_t old_mode)
+{
+    if (frequency < 24 || frequency > 1526)
+        return false;
+
+    // Calcule la valeur du prescaler
+    // Oscillateur interne = 25 MHz
+    float prescale_val = 25000000.0f / (4096.0f * frequency) - 1.0f;
+    uint8_t prescale = (uint8_t)round(prescale_val);
+
     // Entre en mode sommeil pour changer le prescaler
     uint8_t sleep_mode = (old_mode & 0x7F) | SLEEP; // Active le bit SLEEP
     if (!write(MODE1, sleep_mode))
@@ -92,6 +113,32 @@ bool PCA9685::set_time(uint8_t channel, uint16_t on_time, uint16_t off_time)
     if (channel > 15)
         return false;
 
+    // Calcule les adresses des registres pour ce canal
+    uint8_t base = LED0_ON_L + (4 * channel);
+
+    // compactage dans un buffer pour écrire en mode auto-incrémentage
+    uint8_t valeurs[4];
+    encode_time(valeurs, on_time, off_time);
+    return write(base, valeurs, (uint32_t)4);
+}
+
+/**
+ * Définit les temps on/off des 16 canaux en une seule écriture (auto-incrément
+ * de LED0_ON_L à LED15_OFF_H)
+ */
+bool PCA9685::set_time_burst(uint16_t *on_time, uint16_t *off_time)
+{
+    uint8_t frame[4 * CHANNELS];
+    for (uint8_t channel = 0; channel < CHANNELS; channel++)
+        encode_time(&frame[4 * channel], on_time[channel], off_time[channel]);
+    return write(LED0_ON_L, frame, (uint32_t)sizeof(frame));
+}
+
+/**
+ * Remplit les 4 registres LEDn_ON_L, LEDn_ON_H, LEDn_OFF_L, LEDn_OFF_H d'un canal
+ */
+void PCA9685::encode_time(uint8_t *dst, uint16_t on_time, uint16_t off_time)
+{
     // vérifie si les deux temps ne sont pas inversées
     if (on_time > off_time)
     {
@@ -108,25 +155,52 @@ bool PCA9685::set_time(uint8_t channel, uint16_t on_time, uint16_t off_time)
     if (off_time > MAX_PWM)
         off_time = MAX_PWM;
 
-    // Calcule les adresses des registres pour ce canal
-    uint8_t base = LED0_ON_L + (4 * channel);
+    dst[0] = on_time & 0xFF;
+    dst[1] = on_time >> 8;
+    dst[2] = off_time & 0xFF;
+    dst[3] = off_time >> 8;
+}
 
-    // compactage dans un buffer pour écrire en mode auto-incrémentage
-    // uint8_t valeurs[4] = {on_time & 0xFF, on_time >> 8, off_time & 0xFF, off_time >> 8};
-    // return write(base, valeurs, 4);
-    uint16_t valeurs[2] = {on_time, off_time};
-    return write(base, valeurs, 2);
+/**
+ * Remplit les registres d'un canal pour un rapport cyclique (mêmes règles que set_pwm)
+ */
+void PCA9685::encode_pwm(uint8_t *dst, uint16_t duty)
+{
+    if (duty > MAX_PWM)
+        duty = MAX_PWM;
+
+    // Complètement éteint
+    if (duty == 0)
+        encode_time(dst, 0, 0);
+    // Complètement allumé
+    else if (duty == MAX_PWM)
+        encode_time(dst, MAX_PWM, 0);
+    // PWM normal : commence à 0, se termine à la valeur duty
+    else
+        encode_time(dst, 0, duty);
 }
 
-bool PCA9685::set_time_burst(uint16_t *on_time, uint16_t *off_time)
+/**
+ * Comme encode_pwm(dst, duty) mais l'impulsion commence à phase : décaler les canaux
+ * étale les fronts montants sur la période au lieu de démarrer tous les moteurs à 0
+ * Si phase + duty dépasse la période, on_time > off_time : la sortie reste active de
+ * on_time jusqu'à la fin de la période puis de 0 à off_time (pas d'échange des temps
+ * comme dans encode_time)
+ */
+void PCA9685::encode_pwm(uint8_t *dst, uint16_t duty, uint16_t phase)
 {
-    // TODO: utiliser le mode burst avec auto-increment (le seul interet mdr)
-    for (uint8_t channel = 0; channel < 16; channel++)
+    if (duty == 0 || duty >= MAX_PWM || phase == 0)
     {
-        if (!set_time(channel, on_time[channel], off_time[channel]))
-            return false;
+        encode_pwm(dst, duty);
+        return;
     }
-    return true;
+
+    uint16_t on_time = phase & MAX_PWM;
+    uint16_t off_time = (on_time + duty) & MAX_PWM;
+    dst[0] = on_time & 0xFF;
+    dst[1] = on_time >> 8;
+    dst[2] = off_time & 0xFF;
+    dst[3] = off_time >> 8;
 }
 
 /**
@@ -152,6 +226,16 @@ bool PCA9685::set_pwm(uint8_t channel, uint16_t duty)
     return set_time(channel, 0, duty);
 }
 
+/**
+ * Change l'adresse ALL_CALL à laquelle la carte répond (registre ALLCALLADR, adresse sur les bits 7:1)
+ * @param address adresse i2c sur 7 bits
+ * @return true si succès, false sinon
+ */
+bool PCA9685::set_all_call_address(uint8_t address)
+{
+    return write(ALLCALLADR, (uint8_t)(address << 1));
+}
+
 /**
  * Réinitialise le PCA9685 à son état par défaut (soft reset via RESTART bit)
  * Procédure selon datasheet PCA9685:
@@ -172,3 +256,67 @@ bool PCA9685::reset()
     // Envoi du bit RESTART
     return write(MODE1, (uint8_t)0x80);
 }
+
+/**
+ * Éteint complètement les 16 canaux en une écriture : ALL_LED_ON = 0, ALL_LED_OFF = full OFF
+ * Les registres ALL_LED recopient la valeur dans chaque LEDn (auto-incrément requis)
+ * @return true si succès, false sinon
+ */
+bool PCA9685::all_off(I2C_priority priority)
+{
+    uint8_t buf[5] = {ALL_LED_ON_L, 0x00, 0x00, 0x00, FULL_OFF};
+    struct i2c_msg msg;
+    msg.addr = get_address();
+    msg.flags = 0;
+    msg.len = sizeof(buf);
+    msg.buf = buf;
+
+    if (!transfer(&msg, 1, priority))
+    {
+        perror("Error turning all channels off");
+        return false;
+    }
+    return true;
+}
+
+void PCA9685::arm_emergency_stop() const
+{
+    emergency_msg.addr = get_address();
+    emergency_msg.flags = 0;
+    emergency_msg.len = sizeof(emergency_buf);
+    emergency_msg.buf = emergency_buf;
+    emergency_fd = get_bus()->get_fd();
+    I2C_executor::emergency_resend = resend_emergency;
+}
+
+bool PCA9685::resend_emergency()
+{
+    if (emergency_fd < 0)
+        return false;
+    struct i2c_rdwr_ioctl_data ioctl_data = {&emergency_msg, 1};
+    return ioctl(emergency_fd, I2C_RDWR, &ioctl_data) >= 0;
+}
+
+bool PCA9685::emergency_stop()
+{
+    // posé avant l'écriture : une trame en file ne peut plus passer après la coupure
+    I2C_executor::actuation_hold = 1;
+    if (emergency_fd < 0)
+        return false;
+
+    // clock_gettime et ioctl sont des appels système directs, sûrs dans un gestionnaire de signal ;
+    // le noyau sérialise les accès à l'adaptateur avec la transaction éventuellement en cours
+    struct i2c_rdwr_ioctl_data ioctl_data = {&emergency_msg, 1};
+    clock_gettime(CLOCK_MONOTONIC, &emergency_start);
+    bool ok = ioctl(emergency_fd, I2C_RDWR, &ioctl_data) >= 0;
+    clock_gettime(CLOCK_MONOTONIC, &emergency_end);
+    return ok;
+}
+
+long PCA9685::emergency_latency_us()
+{
+    if (emergency_start.tv_sec == 0 && emergency_start.tv_nsec == 0)
+        return -1;
+    return (emergency_end.tv_sec - emergency_start.tv_sec) * 1000000L +
+           (emergency_end.tv_nsec - emergency_start.tv_nsec) / 1000;
+}
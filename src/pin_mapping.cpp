@@ -0,0 +1,213 @@
+#include "pin_mapping.hpp"
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+
+Homography::Homography() : h{1, 0, 0, 0, 1, 0, 0, 0, 1} {}
+
+bool Homography::fit(std::vector<PinPoint> const &points)
+{
+    if (points.size() < 4)
+        return false;
+
+    // u = (h0 x + h1 y + h2) / (h6 x + h7 y + 1), idem v avec h3..h5 :
+    // deux équations linéaires par point, résolues par les équations normales
+    double ata[8][9] = {};
+    for (auto const &p : points)
+    {
+        double x = p.grid_x, y = p.grid_y, u = p.pixel_x, v = p.pixel_y;
+        double rows[2][9] = {{x, y, 1, 0, 0, 0, -x * u, -y * u, u},
+                             {0, 0, 0, x, y, 1, -x * v, -y * v, v}};
+        for (auto const &r : rows)
+            for (int i = 0; i < 8; i++)
+                for (int j = 0; j < 9; j++)
+                    ata[i][j] += r[i] * r[j];
+    }
+
+    // élimination de Gauss avec pivot partiel
+    for (int col = 0; col < 8; col++)
+    {
+        int pivot = col;
+        for (int i = col + 1; i < 8; i++)
+            if (std::abs(ata[i][col]) > std::abs(ata[pivot][col]))
+                pivot = i;
+        if (std::abs(ata[pivot][col]) < 1e-12)
+            return false;
+        std::swap(ata[col], ata[pivot]);
+        for (int i = 0; i < 8; i++)
+        {
+            if (i == col)
+                continue;
+            double f = ata[i][col] / ata[col][col];
+            for (int j = col; j < 9; j++)
+                ata[i][j] -= f * ata[col][j];
+        }
+    }
+    for (int i = 0; i < 8; i++)
+        h[i] = ata[i][8] / ata[i][i];
+    h[8] = 1;
+    return true;
+}
+
+void Homography::apply(float x, float y, float &u, float &v) const
+{
+    double w = h[6] * x + h[7] * y + h[8];
+    u = (h[0] * x + h[1] * y + h[2]) / w;
+    v = (h[3] * x + h[4] * y + h[5]) / w;
+}
+
+Homography Homography::inverse() const
+{
+    // matrice adjointe : l'inverse à un facteur près, normalisée sur le dernier terme
+    Homography inv;
+    double a[9] = {h[4] * h[8] - h[5] * h[7], h[2] * h[7] - h[1] * h[8], h[1] * h[5] - h[2] * h[4],
+                   h[5] * h[6] - h[3] * h[8], h[0] * h[8] - h[2] * h[6], h[2] * h[3] - h[0] * h[5],
+                   h[3] * h[7] - h[4] * h[6], h[1] * h[6] - h[0] * h[7], h[0] * h[4] - h[1] * h[3]};
+    for (int i = 0; i < 9; i++)
+        inv.h[i] = a[i] / a[8];
+    return inv;
+}
+
+PinMapping::PinMapping(int cols, int rows, float footprint_w, float footprint_h, float width, float height)
+    : cols(cols), rows(rows), footprint_w(footprint_w), footprint_h(footprint_h), tables(cols * rows)
+{
+    fit({{0, 0, 0, 0}, {(float)cols, 0, width, 0}, {(float)cols, (float)rows, width, height}, {0, (float)rows, 0, height}});
+}
+
+bool PinMapping::fit(std::vector<PinPoint> const &calibration)
+{
+    Homography h;
+    if (!h.fit(calibration))
+        return false;
+
+    double sq = 0;
+    for (auto const &p : calibration)
+    {
+        float u, v;
+        h.apply(p.grid_x, p.grid_y, u, v);
+        sq += (u - p.pixel_x) * (u - p.pixel_x) + (v - p.pixel_y) * (v - p.pixel_y);
+    }
+    points = calibration;
+    grid_to_image = h;
+    image_to_grid = h.inverse();
+    rms_error = std::sqrt(sq / calibration.size());
+    return true;
+}
+
+// une ligne par point : grid_x grid_y pixel_x pixel_y, '#' pour les commentaires
+bool PinMapping::load(const char *path)
+{
+    FILE *f = fopen(path, "r");
+    if (!f)
+        return false;
+
+    std::vector<PinPoint> calibration;
+    char line[256];
+    while (fgets(line, sizeof(line), f))
+    {
+        PinPoint p;
+        if (line[0] != '#' && sscanf(line, "%f %f %f %f", &p.grid_x, &p.grid_y, &p.pixel_x, &p.pixel_y) == 4)
+            calibration.push_back(p);
+    }
+    fclose(f);
+
+    if (!fit(calibration))
+    {
+        fprintf(stderr, "%s : %zu point(s), homographie impossible à ajuster\n", path, calibration.size());
+        return false;
+    }
+    return true;
+}
+
+bool PinMapping::save(const char *path) const
+{
+    FILE *f = fopen(path, "w");
+    if (!f)
+    {
+        perror("Failed to write pin mapping");
+        return false;
+    }
+    fprintf(f, "# grille %dx%d pins : grid_x grid_y pixel_x pixel_y (au moins 4 points)\n", cols, rows);
+    for (auto const &p : points)
+        fprintf(f, "%g %g %g %g\n", p.grid_x, p.grid_y, p.pixel_x, p.pixel_y);
+    return fclose(f) == 0;
+}
+
+Rect PinMapping::bounds(int pin) const
+{
+    float cx = pin % cols + 0.5f, cy = pin / cols + 0.5f, half_w = footprint_w / 2, half_h = footprint_h / 2;
+    float x0 = KINECT_W, y0 = KINECT_H, x1 = 0, y1 = 0;
+
+    // les bords d'un rectangle restent droits par homographie : les coins suffisent
+    for (int corner = 0; corner < 4; corner++)
+    {
+        float u, v;
+        grid_to_image.apply(cx + (corner & 1 ? half_w : -half_w), cy + (corner & 2 ? half_h : -half_h), u, v);
+        x0 = std::min(x0, u), x1 = std::max(x1, u);
+        y0 = std::min(y0, v), y1 = std::max(y1, v);
+    }
+    int left = std::max((int)std::floor(x0), 0), top = std::max((int)std::floor(y0), 0);
+    int right = std::min((int)std::ceil(x1), KINECT_W), bottom = std::min((int)std::ceil(y1), KINECT_H);
+    return {left, top, std::max(right - left, 0), std::max(bottom - top, 0)};
+}
+
+void PinMapping::build(DepthFrame const &frame, bool weighted)
+{
+    float half_w = footprint_w / 2, half_h = footprint_h / 2;
+    for (int pin = 0; pin < cols * rows; pin++)
+    {
+        PixelTable &table = tables[pin];
+        table.offsets.clear();
+        table.weights.clear();
+        table.runs.clear();
+        float cx = pin % cols + 0.5f, cy = pin / cols + 0.5f;
+        Rect b = bounds(pin);
+
+        for (int y = b.y; y < b.y + b.h; y++)
+        {
+            for (int x = b.x; x < b.x + b.w; x++)
+            {
+                // centre du pixel ramené dans la grille, puis dans le rectangle du pin [-1, 1]²
+                float gx, gy;
+                image_to_grid.apply(x + 0.5f, y + 0.5f, gx, gy);
+                float a = std::abs(gx - cx) / half_w, c = std::abs(gy - cy) / half_h;
+                if (a > 1 || c > 1 || !frame.contains(x, y))
+                    continue;
+                uint32_t offset = frame.row(y) * frame.get_width() + frame.col(x);
+                if (weighted)
+                {
+                    // poids en tente : le centre du pin compte plus que ses bords
+                    table.offsets.push_back(offset);
+                    table.weights.push_back(1 + (uint16_t)std::lround(255 * (1 - a) * (1 - c)));
+                }
+                // pixel à la suite du segment précédent : on l'allonge
+                else if (!table.runs.empty() && table.runs.back().offset + table.runs.back().length == offset)
+                    table.runs.back().length++;
+                else
+                    table.runs.push_back({offset, 1});
+            }
+        }
+    }
+}
+
+SamplePattern PinMapping::sample(DepthFrame const &frame, int pin, int count) const
+{
+    // R2 (Roberts) : pas de 1/g et 1/g² avec g solution de x³ = x + 1, couvre le plan sans amas
+    const double g = 1.32471795724474602596;
+    const double a1 = 1.0 / g, a2 = 1.0 / (g * g);
+    float cx = pin % cols + 0.5f, cy = pin / cols + 0.5f;
+    SamplePattern pattern;
+
+    for (int i = 0; i < count; i++)
+    {
+        double s = std::fmod(0.5 + a1 * i, 1.0), t = std::fmod(0.5 + a2 * i, 1.0);
+        float u, v;
+        grid_to_image.apply(cx + (s - 0.5) * footprint_w, cy + (t - 0.5) * footprint_h, u, v);
+        int x = (int)u, y = (int)v;
+        if (frame.contains(x, y))
+            pattern.offsets.push_back(frame.row(y) * frame.get_width() + frame.col(x));
+    }
+    std::sort(pattern.offsets.begin(), pattern.offsets.end());
+    pattern.offsets.erase(std::unique(pattern.offsets.begin(), pattern.offsets.end()), pattern.offsets.end());
+    return pattern;
+}
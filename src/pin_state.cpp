@@ -0,0 +1,105 @@
+#include "pin_state.hpp"
+#include <cstdio>
+#include <cstring>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <unistd.h>
+
+PinStateStore::PinStateStore(int motors)
+    : motors(motors), slot_size((sizeof(Slot) + motors * sizeof(float) + 7) & ~(size_t)7), map_size(2 * slot_size)
+{
+}
+
+PinStateStore::~PinStateStore()
+{
+    if (map)
+        munmap(map, map_size);
+    if (fd >= 0)
+        close(fd);
+}
+
+bool PinStateStore::open(const char *path)
+{
+    fd = ::open(path, O_RDWR | O_CREAT, 0644);
+    if (fd < 0)
+    {
+        perror("Failed to open pin state");
+        return false;
+    }
+    // un fichier neuf ou d'une autre taille est remis à zéro : aucun emplacement valide
+    off_t size = lseek(fd, 0, SEEK_END);
+    if (size != (off_t)map_size && (ftruncate(fd, 0) != 0 || ftruncate(fd, map_size) != 0))
+    {
+        perror("Failed to resize pin state");
+        close(fd);
+        fd = -1;
+        return false;
+    }
+    void *p = mmap(nullptr, map_size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    if (p == MAP_FAILED)
+    {
+        perror("Failed to map pin state");
+        close(fd);
+        fd = -1;
+        return false;
+    }
+    map = static_cast<uint8_t *>(p);
+
+    // les sauvegardes suivantes continuent la séquence du fichier
+    for (int k = 0; k < 2; k++)
+        if (valid(slot(k)) && slot(k)->sequence > sequence)
+            sequence = slot(k)->sequence;
+    return true;
+}
+
+uint32_t PinStateStore::checksum(Slot const *s) const
+{
+    uint8_t const *p = reinterpret_cast<uint8_t const *>(&s->sequence);
+    size_t n = offsetof(Slot, positions) - offsetof(Slot, sequence) + motors * sizeof(float);
+    uint32_t h = 2166136261u;
+    for (size_t i = 0; i < n; i++)
+        h = (h ^ p[i]) * 16777619u;
+    return h;
+}
+
+bool PinStateStore::valid(Slot const *s) const
+{
+    return s->magic == MAGIC && s->motors == motors && s->checksum == checksum(s);
+}
+
+bool PinStateStore::resume(float *positions, bool &trusted) const
+{
+    if (!map)
+        return false;
+    Slot const *best = nullptr;
+    for (int k = 0; k < 2; k++)
+        if (valid(slot(k)) && (!best || slot(k)->sequence > best->sequence))
+            best = slot(k);
+    if (!best)
+        return false;
+    memcpy(positions, best->positions, motors * sizeof(float));
+    trusted = best->clean;
+    return true;
+}
+
+void PinStateStore::checkpoint(float const *positions, bool clean, bool sync)
+{
+    if (!map)
+        return;
+    sequence++;
+    Slot *s = slot(sequence & 1);
+    // emplacement invalidé pendant l'écriture : une sauvegarde interrompue ne peut pas passer pour valide
+    s->magic = 0;
+    __atomic_thread_fence(__ATOMIC_RELEASE);
+    memcpy(s->positions, positions, motors * sizeof(float));
+    s->sequence = sequence;
+    s->motors = motors;
+    s->clean = clean;
+    s->reserved = 0;
+    s->checksum = checksum(s);
+    __atomic_thread_fence(__ATOMIC_RELEASE);
+    s->magic = MAGIC;
+    // quelques dizaines d'octets : on synchronise toute la projection (alignée sur une page)
+    msync(map, map_size, sync ? MS_SYNC : MS_ASYNC);
+    checkpoints++;
+}
@@ -0,0 +1,135 @@
+#include "pwm_bank.hpp"
+#include <unistd.h>
+
+PwmBank::PwmBank(uint8_t nb_boards, uint8_t first_address, const char *bus_path, uint8_t all_call_address)
+    : all_call(all_call_address, bus_path), all_call_address(all_call_address)
+{
+    boards.resize(nb_boards);
+    for (uint8_t b = 0; b < nb_boards; b++)
+    {
+        boards[b].pca = new PCA9685(first_address + b, bus_path);
+        boards[b].frame[0] = PCA9685::LED0_ON_L;
+        for (uint8_t c = 0; c < PCA9685::CHANNELS; c++)
+            PCA9685::encode_pwm(&boards[b].frame[1 + 4 * c], 0);
+        boards[b].dirty = true;
+    }
+}
+
+PwmBank::~PwmBank()
+{
+    for (auto &board : boards)
+        delete board.pca;
+}
+
+bool PwmBank::init(uint16_t frequency)
+{
+    // Reset et configuration carte par carte (MODE1 est relu, il faut une adresse unique)
+    for (auto &board : boards)
+    {
+        if (!board.pca->reset())
+            return false;
+        if (!board.pca->write(PCA9685::MODE1, PCA9685::MODE1_DEFAULT))
+            return false;
+        if (!board.pca->write(PCA9685::MODE2, (uint8_t)0x04)) // OUTDRV : totem pole
+            return false;
+        if (!board.pca->set_all_call_address(all_call_address))
+            return false;
+    }
+
+    // Toutes les cartes sont dans le même mode : fréquence réglée en une fois
+    if (!all_call.set_frequency(frequency, PCA9685::MODE1_DEFAULT))
+        return false;
+
+    // Ctrl+C coupe toutes les cartes depuis le gestionnaire de signal
+    all_call.arm_emergency_stop();
+
+    // Sorties à l'arrêt, trames envoyées au prochain flush
+    for (auto &board : boards)
+        board.dirty = true;
+    return flush();
+}
+
+void PwmBank::set_motor(uint16_t motor, uint16_t duty_a, uint16_t duty_b)
+{
+    if (motor >= motors())
+        return;
+
+    Board &board = boards[motor / MOTORS_PER_BOARD];
+    uint8_t channel = 2 * (motor % MOTORS_PER_BOARD);
+    // impulsions décalées d'un moteur à l'autre : les pics de courant au démarrage de
+    // chaque impulsion ne tombent plus tous au début de la période
+    uint16_t phase = (motor % MOTORS_PER_BOARD) * (PCA9685::MAX_PWM + 1) / MOTORS_PER_BOARD;
+    uint8_t regs[8];
+    PCA9685::encode_pwm(&regs[0], duty_a, phase);
+    PCA9685::encode_pwm(&regs[4], duty_b, phase);
+
+    uint8_t *dst = &board.frame[1 + 4 * channel];
+    if (memcmp(dst, regs, sizeof(regs)) != 0)
+    {
+        memcpy(dst, regs, sizeof(regs));
+        board.dirty = true;
+    }
+}
+
+bool PwmBank::flush()
+{
+    struct i2c_msg msgs[boards.size()];
+    uint32_t nmsgs = 0;
+
+    if (outputs_lost.exchange(false))
+    {
+        for (auto &board : boards)
+            board.dirty = true;
+    }
+
+    for (auto &board : boards)
+    {
+        if (!board.dirty)
+            continue;
+        msgs[nmsgs].addr = board.pca->get_address();
+        msgs[nmsgs].flags = 0;
+        msgs[nmsgs].len = FRAME_SIZE;
+        msgs[nmsgs].buf = board.frame;
+        nmsgs++;
+    }
+    if (nmsgs == 0)
+        return true;
+    // arrêt d'urgence : les trames restent en mémoire, rien n'est envoyé avant all_stop() ;
+    // un verrou posé après ce test est rattrapé par l'executor, qui renvoie la coupure
+    if (PCA9685::emergency_latched())
+        return false;
+
+    transactions++;
+    if (!all_call.get_bus()->transfer(msgs, nmsgs, I2C_PRIO_ACTUATION))
+    {
+        perror("Error writing PWM frames");
+        return false;
+    }
+    for (auto &board : boards)
+        board.dirty = false;
+    return true;
+}
+
+bool PwmBank::all_stop()
+{
+    // ALL_LED_OFF envoyé à l'adresse ALL_CALL : toutes les cartes, tous les canaux
+    if (!all_call.all_off())
+        return false;
+    // sorties coupées par une écriture normale : les commandes peuvent reprendre
+    PCA9685::clear_emergency();
+
+    // l'état en mémoire suit les sorties
+    for (auto &board : boards)
+    {
+        for (uint8_t c = 0; c < PCA9685::CHANNELS; c++)
+            PCA9685::encode_pwm(&board.frame[1 + 4 * c], 0);
+        board.dirty = false;
+    }
+    return true;
+}
+
+bool PwmBank::force_stop()
+{
+    outputs_lost = true;
+    return all_call.all_off();
+}
@@ -0,0 +1,163 @@
+#include "sensor_health.hpp"
+#include <chrono>
+#include <algorithm>
+#include <cstdio>
+
+// poids d'une interrogation dans les moyennes glissantes
+static constexpr float RATE_ALPHA = 0.05f;
+
+SensorHealth::SensorHealth(int sensors, SensorHealthConfig const &config)
+    : sensors(sensors), config(config), slots(new Slot[sensors])
+{
+}
+
+SensorHealth::~SensorHealth()
+{
+    stop();
+}
+
+void SensorHealth::start(std::function<bool(int)> recover)
+{
+    std::lock_guard<std::mutex> lock(mutex);
+    if (running)
+        return;
+    this->recover = recover;
+    running = true;
+    worker = std::thread(&SensorHealth::loop, this);
+}
+
+void SensorHealth::stop()
+{
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        running = false;
+    }
+    wake.notify_all();
+    if (worker.joinable())
+        worker.join();
+}
+
+void SensorHealth::clear(Slot &slot)
+{
+    slot.timeout_rate = slot.invalid_rate = 0;
+    slot.events = 0;
+    slot.repeats = 0;
+    slot.last_reading_us = 0; // repart de la prochaine interrogation
+}
+
+void SensorHealth::record(int sensor, uint64_t t_us, SensorResult result, uint16_t range, bool moving)
+{
+    Slot &slot = slots[sensor];
+    if (slot.quarantined)
+        return;
+    if (!slot.last_reading_us)
+        slot.last_reading_us = t_us;
+
+    // une absence de mesure ne compte qu'une fois par délai écoulé
+    bool timeout = result == SENSOR_ERROR;
+    if (result == SENSOR_PENDING)
+    {
+        if (t_us - slot.last_reading_us < config.timeout_us)
+            return;
+        timeout = true;
+        slot.last_reading_us = t_us;
+    }
+    else if (result != SENSOR_ERROR)
+    {
+        slot.last_reading_us = t_us;
+        slot.invalid_rate += RATE_ALPHA * ((result == SENSOR_INVALID) - slot.invalid_rate);
+    }
+    slot.timeout_rate += RATE_ALPHA * (timeout - slot.timeout_rate);
+    slot.events++;
+
+    if (result == SENSOR_VALID)
+    {
+        slot.repeats = moving && range == slot.last_range ? slot.repeats + 1 : 0;
+        slot.last_range = range;
+    }
+
+    if (slot.repeats >= config.stuck_count)
+        quarantine(sensor, "valeur figée");
+    else if (slot.events >= config.min_events && slot.timeout_rate > config.max_timeout_rate)
+        quarantine(sensor, "timeouts");
+    else if (slot.events >= config.min_events && slot.invalid_rate > config.max_invalid_rate)
+        quarantine(sensor, "mesures invalides");
+}
+
+void SensorHealth::quarantine(int sensor, const char *reason)
+{
+    Slot &slot = slots[sensor];
+    slot.reason = reason;
+    slot.quarantines++;
+    slot.quarantined = true;
+    fprintf(stderr, "[VL53L0X] Capteur %d en quarantaine (%s), reprise en arrière-plan\n", sensor, reason);
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        pending.push_back(sensor);
+    }
+    wake.notify_one();
+}
+
+void SensorHealth::loop()
+{
+    using clock = std::chrono::steady_clock;
+    std::vector<uint32_t> delay_ms(sensors, config.retry_ms);
+    std::vector<clock::time_point> retry_at(sensors);
+    std::unique_lock<std::mutex> lock(mutex);
+    while (running)
+    {
+        // capteur en attente dont la tentative est la plus proche
+        auto next = pending.end();
+        for (auto it = pending.begin(); it != pending.end(); ++it)
+            if (next == pending.end() || retry_at[*it] < retry_at[*next])
+                next = it;
+        if (next == pending.end())
+        {
+            wake.wait(lock);
+            continue;
+        }
+        if (retry_at[*next] > clock::now())
+        {
+            wake.wait_until(lock, retry_at[*next]);
+            continue;
+        }
+        int sensor = *next;
+        pending.erase(next);
+
+        // réinitialisation hors verrou : peut durer plusieurs centaines de ms
+        lock.unlock();
+        bool ok = recover && recover(sensor);
+        lock.lock();
+
+        Slot &slot = slots[sensor];
+        if (ok)
+        {
+            delay_ms[sensor] = config.retry_ms;
+            slot.recoveries++;
+            // statistiques remises à zéro avant que la boucle ne s'en serve à nouveau
+            clear(slot);
+            slot.quarantined = false;
+            fprintf(stderr, "[VL53L0X] Capteur %d repris\n", sensor);
+            continue;
+        }
+        fprintf(stderr, "[VL53L0X] Reprise du capteur %d échouée, nouvel essai dans %u ms\n", sensor,
+                delay_ms[sensor]);
+        retry_at[sensor] = clock::now() + std::chrono::milliseconds(delay_ms[sensor]);
+        delay_ms[sensor] = std::min(2 * delay_ms[sensor], config.max_retry_ms);
+        pending.push_back(sensor);
+    }
+}
+
+void SensorHealth::print_stats() const
+{
+    printf("===== VL53L0X =====\n");
+    for (int i = 0; i < sensors; i++)
+    {
+        Slot const &slot = slots[i];
+        if (!slot.quarantines)
+            continue;
+        printf("capteur %d : %u quarantaine(s), %u reprise(s), dernière cause : %s%s\n", i,
+               slot.quarantines.load(), slot.recoveries.load(), slot.reason,
+               slot.quarantined ? " (toujours en quarantaine)" : "");
+    }
+}
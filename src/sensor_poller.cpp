@@ -0,0 +1,45 @@
+#include "sensor_poller.hpp"
+#include <algorithm>
+
+// coût d'une interrogation avant la première mesure : lecture d'état puis du résultat à 400 kHz
+static constexpr float INITIAL_COST_US = 300;
+
+SensorPoller::SensorPoller(int sensors, uint32_t const interval_us[3], uint32_t budget_us)
+    : sensors(sensors), budget_us(budget_us), last_us(sensors, 0), cost_us(sensors, INITIAL_COST_US),
+      lateness(sensors, 0)
+{
+    std::copy(interval_us, interval_us + 3, this->interval_us);
+}
+
+int SensorPoller::schedule(uint64_t t_us, SensorActivity const *activity, int *order)
+{
+    int due = 0;
+    for (int i = 0; i < sensors; i++)
+    {
+        if (activity[i] == SENSOR_NONE)
+            continue;
+        lateness[i] = (float)(t_us - last_us[i]) / interval_us[activity[i]];
+        if (lateness[i] >= 1)
+            order[due++] = i;
+    }
+    std::sort(order, order + due, [&](int a, int b)
+              { return lateness[a] > lateness[b]; });
+
+    float spent = 0;
+    int n = 0;
+    while (n < due && (n == 0 || spent + cost_us[order[n]] <= budget_us))
+        spent += cost_us[order[n++]];
+    deferred += due - n;
+    return n;
+}
+
+void SensorPoller::done(int sensor, uint64_t t_us, uint32_t cost, bool measured)
+{
+    cost_us[sensor] += 0.1f * (cost - cost_us[sensor]);
+    polls++;
+    if (measured)
+    {
+        last_us[sensor] = t_us;
+        readings++;
+    }
+}
@@ -0,0 +1,161 @@
+#include "speed_model.hpp"
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <algorithm>
+
+SpeedModel::SpeedModel(int motors, uint16_t duty_min, uint16_t duty_max, float default_speed)
+    : motors(motors), duty_min(duty_min), duty_max(duty_max), curves(2 * motors * POINTS)
+{
+    for (int i = 0; i < 2 * motors; i++)
+        for (int k = 0; k < POINTS; k++)
+            curves[i * POINTS + k] = default_speed * duty_point(k) / duty_max;
+}
+
+// Segment [k, k + 1] de la courbe qui contient d (>= duty_min) et position w dans ce segment
+void SpeedModel::segment(int d, int &k, float &w) const
+{
+    k = 0;
+    while (k < POINTS - 2 && d >= duty_point(k + 1))
+        k++;
+    w = std::min(1.0f, (float)(d - duty_point(k)) / (duty_point(k + 1) - duty_point(k)));
+}
+
+float SpeedModel::speed(int motor, int16_t duty) const
+{
+    if (duty == 0 || motor < 0 || motor >= motors)
+        return 0;
+    float const *v = curve(motor, duty);
+    int d = std::abs(duty);
+    float s;
+    if (d <= duty_min)
+        s = v[0] * d / duty_min;
+    else
+    {
+        int k;
+        float w;
+        segment(d, k, w);
+        s = v[k] + w * (v[k + 1] - v[k]);
+    }
+    return duty > 0 ? s : -s;
+}
+
+void SpeedModel::observe(int motor, int16_t duty, float measured, float gain)
+{
+    int d = std::abs(duty);
+    if (motor < 0 || motor >= motors || d < duty_min)
+        return;
+    // une mesure de sens opposé à la commande n'est pas une vitesse du moteur (butée, choc)
+    if ((measured > 0) != (duty > 0))
+        return;
+
+    float *v = curve(motor, duty);
+    int k;
+    float w;
+    segment(d, k, w);
+    float error = std::abs(measured) - std::abs(speed(motor, duty));
+    v[k] += gain * (1 - w) * error;
+    v[k + 1] += gain * w * error;
+    samples++;
+}
+
+bool SpeedModel::load(const char *path)
+{
+    FILE *f = fopen(path, "r");
+    if (!f)
+        return false;
+
+    static_assert(POINTS == 5, "format de lecture à adapter");
+    // sans ligne duty (ancien fichier), les points sont supposés pris sur la grille courante
+    int grid[POINTS];
+    for (int k = 0; k < POINTS; k++)
+        grid[k] = duty_point(k);
+
+    int loaded = 0;
+    foreign.clear();
+    char line[256];
+    while (fgets(line, sizeof(line), f))
+    {
+        ForeignCurve c;
+        int g[POINTS];
+        if (line[0] == '#')
+            continue;
+        if (sscanf(line, "duty %d %d %d %d %d", &g[0], &g[1], &g[2], &g[3], &g[4]) == POINTS)
+        {
+            bool increasing = g[0] > 0;
+            for (int k = 1; k < POINTS; k++)
+                increasing = increasing && g[k] > g[k - 1];
+            if (increasing)
+                memcpy(grid, g, sizeof(grid));
+            continue;
+        }
+        if (sscanf(line, "%d %c %f %f %f %f %f", &c.motor, &c.sens, &c.v[0], &c.v[1], &c.v[2], &c.v[3],
+                   &c.v[4]) != 2 + POINTS)
+            continue;
+        if (c.motor < 0 || (c.sens != '+' && c.sens != '-'))
+            continue;
+        if (c.motor >= motors)
+        {
+            memcpy(c.grid, grid, sizeof(grid));
+            foreign.push_back(c);
+            continue;
+        }
+
+        // vitesse aux points de la grille courante, interpolée sur la grille du fichier
+        float v[POINTS];
+        for (int k = 0; k < POINTS; k++)
+        {
+            int d = duty_point(k);
+            int j = 0;
+            while (j < POINTS - 2 && d >= grid[j + 1])
+                j++;
+            float w = std::min(1.0f, (float)(d - grid[j]) / (grid[j + 1] - grid[j]));
+            v[k] = d <= grid[0] ? c.v[0] * d / grid[0] : c.v[j] + w * (c.v[j + 1] - c.v[j]);
+        }
+        memcpy(curve(c.motor, c.sens == '+' ? 1 : -1), v, sizeof(v));
+        loaded++;
+    }
+    fclose(f);
+    return loaded > 0;
+}
+
+bool SpeedModel::save(const char *path) const
+{
+    FILE *f = fopen(path, "w");
+    if (!f)
+    {
+        perror("Failed to write speed model");
+        return false;
+    }
+    fprintf(f, "# rapports cycliques des points, puis moteur sens vitesses (mm/s) à ces points\n");
+    fprintf(f, "duty");
+    for (int k = 0; k < POINTS; k++)
+        fprintf(f, " %u", duty_point(k));
+    fprintf(f, "\n");
+    for (int motor = 0; motor < motors; motor++)
+        for (int sens = 1; sens >= -1; sens -= 2)
+        {
+            float const *v = curve(motor, sens);
+            fprintf(f, "%d %c", motor, sens > 0 ? '+' : '-');
+            for (int k = 0; k < POINTS; k++)
+                fprintf(f, " %.3f", v[k]);
+            fprintf(f, "\n");
+        }
+    // courbes d'autres moteurs lues dans le fichier, à ne pas perdre, chacune sur sa grille
+    for (size_t i = 0; i < foreign.size(); i++)
+    {
+        ForeignCurve const &c = foreign[i];
+        if (i == 0 || memcmp(c.grid, foreign[i - 1].grid, sizeof(c.grid)) != 0)
+        {
+            fprintf(f, "duty");
+            for (int k = 0; k < POINTS; k++)
+                fprintf(f, " %d", c.grid[k]);
+            fprintf(f, "\n");
+        }
+        fprintf(f, "%d %c", c.motor, c.sens);
+        for (int k = 0; k < POINTS; k++)
+            fprintf(f, " %.3f", c.v[k]);
+        fprintf(f, "\n");
+    }
+    return fclose(f) == 0;
+}
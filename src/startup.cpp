@@ -0,0 +1,56 @@
+#include "startup.hpp"
+#include <time.h>
+
+// temps monotone en ms
+static uint32_t now_ms()
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec * 1000 + ts.tv_nsec / 1000000;
+}
+
+void Startup::add(std::string name, std::function<bool()> step)
+{
+    steps.push_back({name, step, 0, 0, false});
+}
+
+bool Startup::run()
+{
+    std::vector<std::thread> threads;
+    uint32_t t0 = now_ms();
+
+    for (auto &step : steps)
+    {
+        threads.emplace_back([&step, t0]()
+                             {
+            step.start_ms = now_ms() - t0;
+            step.ok = step.fn();
+            step.end_ms = now_ms() - t0; });
+    }
+    for (auto &t : threads)
+        t.join();
+
+    total_ms = now_ms() - t0;
+
+    bool ok = true;
+    for (auto const &step : steps)
+        ok &= step.ok;
+    return ok;
+}
+
+void Startup::print_timeline() const
+{
+    // largeur de la barre pour la durée totale
+    const int width = 50;
+
+    printf("===== DEMARRAGE : %u ms =====\n", total_ms);
+    for (auto const &step : steps)
+    {
+        int from = total_ms ? step.start_ms * width / total_ms : 0;
+        int to = total_ms ? step.end_ms * width / total_ms : 0;
+        printf("%-12s %5u -> %5u ms %s |", step.name.c_str(), step.start_ms, step.end_ms, step.ok ? "  " : "KO");
+        for (int i = 0; i < width; i++)
+            printf(i < from ? " " : (i <= to ? "#" : " "));
+        printf("|\n");
+    }
+}
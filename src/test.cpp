@@ -9,6 +9,8 @@ void signal_handler(int signal)
     (void)signal; // Unused parameter
     if (Test::should_exit)
         std::exit(0);
+    // moteurs coupés avant toute autre chose (sans effet si aucun PCA9685 n'est armé)
+    PCA9685::emergency_stop();
     Test::should_exit = 1;
     printf("\n\nArrêt du programme...\n");
 }
@@ -55,6 +57,7 @@ Test::~Test()
 {
     if (pca9685)
     {
+        pca9685->all_off();
         pca9685->reset();
         delete pca9685;
     }
@@ -70,6 +73,7 @@ int Test::scenario_calibrage()
         printf("Erreur d'initialisation du PCA9685\n");
         return 1;
     }
+    pca.arm_emergency_stop();
 
     int motor_selected = 0;
     bool running = true;
@@ -78,6 +82,7 @@ int Test::scenario_calibrage()
     printf("=== CONTROLE MANUEL DES MOTEURS ===\n");
     printf("Utilisez les fleches GAUCHE/DROITE pour choisir le moteur\n");
     printf("Utilisez les fleches HAUT/BAS pour faire tourner\n");
+    printf("Appuyez sur 'v' pour mesurer les vitesses du moteur choisi\n");
     printf("Appuyez sur 'q' pour quitter\n\n");
 
     while (running && !should_exit)
@@ -92,6 +97,10 @@ int Test::scenario_calibrage()
         {
             running = false;
         }
+        else if (c == 'v')
+        {
+            calibrate_speed(pca, motor_selected);
+        }
         else if (c == 27)
         {            // Séquence d'échappement pour les flèches
             getch(); // ignore [
@@ -121,13 +130,55 @@ int Test::scenario_calibrage()
     }
 
     // Sécurité : tout éteindre avant de quitter
-    for (int i = 0; i < 16; i++)
-        pca.set_pwm(i, 0);
+    pca.all_off();
     printf("\nFin du contrôle manuel.\n");
     return 0;
 
     return 0;
 }
+/**
+ * Mesure chronométrée des courbes de vitesse d'un moteur sans capteur : le pin est
+ * d'abord ramené en butée basse, puis pour chaque point de la courbe il parcourt la
+ * course complète en montée puis en descente ; l'utilisateur appuie sur une touche
+ * quand il atteint la butée. Les courbes des autres moteurs sont conservées.
+ */
+void Test::calibrate_speed(PCA9685 &pca, int motor)
+{
+    // mêmes paramètres que la boucle principale : les points mesurés sont ceux qu'elle relira
+    SpeedModel model(TOTAL_MOTORS, VMOY, VMAX, VITESSE_MM_S);
+    model.load(SPEED_MODEL_FILE);
+
+    printf("\nRetour en butée basse...\n");
+    pca.set_pwm(motor * 2, 0);
+    pca.set_pwm(motor * 2 + 1, PCA9685::MAX_PWM);
+    usleep((useconds_t)(2 * COURSE_MAX / VITESSE_MM_S * 1e6f));
+    pca.set_pwm(motor * 2 + 1, 0);
+
+    for (int k = 0; k < SpeedModel::POINTS && !should_exit; k++)
+    {
+        uint16_t duty = model.duty_point(k);
+        for (int sens = 1; sens >= -1 && !should_exit; sens -= 2)
+        {
+            printf("Rapport %u, %s : touche à l'arrivée en butée\n", duty, sens > 0 ? "montée" : "descente");
+            struct timespec start, end;
+            clock_gettime(CLOCK_MONOTONIC, &start);
+            pca.set_pwm(motor * 2, sens > 0 ? duty : 0);
+            pca.set_pwm(motor * 2 + 1, sens > 0 ? 0 : duty);
+            getch();
+            clock_gettime(CLOCK_MONOTONIC, &end);
+            pca.set_pwm(motor * 2, 0);
+            pca.set_pwm(motor * 2 + 1, 0);
+
+            float seconds = (end.tv_sec - start.tv_sec) + (end.tv_nsec - start.tv_nsec) / 1e9f;
+            float speed = COURSE_MAX / seconds;
+            printf("  %.2f s, %.2f mm/s\n", seconds, speed);
+            model.observe(motor, sens * duty, sens * speed, 1.0f);
+        }
+    }
+    if (!should_exit && model.save(SPEED_MODEL_FILE))
+        printf("Courbes enregistrées dans %s\n", SPEED_MODEL_FILE);
+}
+
 int Test::scenario_matrix()
 {
     // Implémentation du scénario matrix
@@ -197,7 +248,7 @@ int Test::scenario_matrix()
 int Test::scenario_vl53l0x()
 {
     VL53L0X dev;
-    if (!dev.init())
+    if (!dev.init(true, VL53L0X_CALIBRATION_FILE))
     {
         fprintf(stderr, "Erreur initialisation VL53L0X\n");
         return EXIT_FAILURE;
@@ -206,17 +257,25 @@ int Test::scenario_vl53l0x()
     printf("Mesure de distance...\n");
     while (!should_exit)
     {
-        uint16_t distancemoyenne = 0;
+        // somme sur 32 bits : 30 mesures de 65535 (timeout) dépassent un uint16_t
+        uint32_t somme = 0;
+        int valides = 0;
         for (int i = 0; i < 30; i++)
         {
             uint16_t distance = dev.readRangeSingleMillimeters();
-            distancemoyenne += distance;
+            // une mesure en timeout (65535) n'est pas une distance
             if (dev.timeoutOccurred())
             {
                 printf("Timeout !\n");
+                continue;
             }
+            somme += distance;
+            valides++;
         }
-        printf("Distance : %u mm\n", distancemoyenne / 30);
+        if (valides)
+            printf("Distance : %u mm (%d/30 mesures)\n", (unsigned)(somme / valides), valides);
+        else
+            printf("Distance : aucune mesure\n");
         usleep(1000);
     }
     return EXIT_SUCCESS;
@@ -342,6 +401,7 @@ int Test::scenario_pca9685(uint8_t a)
         printf("ERREUR: PCA9685 non trouvé\n");
         return 1;
     }
+    pca9685->arm_emergency_stop();
     // test du pca9685
 
     while (!should_exit)
@@ -0,0 +1,80 @@
+#include "tile_detector.hpp"
+#include <algorithm>
+#include <cstdio>
+#include <cstdlib>
+
+TileDetector::TileDetector(DepthFrame const &frame, uint16_t ceiling, uint16_t mean_delta, uint16_t range_delta)
+    : frame(frame), ceiling(ceiling), mean_delta(mean_delta), range_delta(range_delta)
+{
+    tiles_x = (frame.get_width() + TILE - 1) / TILE;
+    tiles_y = (frame.get_height() + TILE - 1) / TILE;
+    previous.resize(tiles_x * tiles_y);
+    dirty.assign(tiles_x * tiles_y, true);
+}
+
+void TileDetector::update()
+{
+    int width = frame.get_width(), height = frame.get_height();
+    uint16_t const *data = frame.get_data();
+
+    for (int ty = 0; ty < tiles_y; ty++)
+    {
+        for (int tx = 0; tx < tiles_x; tx++)
+        {
+            int x0 = tx * TILE, x1 = std::min(x0 + TILE, width);
+            int y0 = ty * TILE, y1 = std::min(y0 + TILE, height);
+            Signature s = {0, UINT16_MAX, 0};
+            for (int y = y0; y < y1; y++)
+            {
+                uint16_t const *line = &data[y * width];
+                for (int x = x0; x < x1; x++)
+                {
+                    uint16_t v = std::min(line[x], ceiling);
+                    s.sum += v;
+                    s.min = std::min(s.min, v);
+                    s.max = std::max(s.max, v);
+                }
+            }
+
+            // les tuiles de bord peuvent être incomplètes : comparaison sur la moyenne
+            int count = (x1 - x0) * (y1 - y0);
+            int idx = ty * tiles_x + tx;
+            Signature const &p = previous[idx];
+            bool d = !primed || (uint32_t)std::abs((int)s.sum - (int)p.sum) > (uint32_t)mean_delta * count ||
+                     std::abs(s.min - p.min) > range_delta || std::abs(s.max - p.max) > range_delta;
+
+            // la référence n'avance que sur changement : une dérive lente finit par être détectée
+            if (d)
+                previous[idx] = s;
+            dirty[idx] = d;
+            tiles_checked++;
+            tiles_dirty += d;
+        }
+    }
+    primed = true;
+}
+
+bool TileDetector::changed(Rect const &window)
+{
+    int tx0 = frame.col(window.x) / TILE, tx1 = (frame.col(window.x) + window.w - 1) / TILE;
+    int ty0 = frame.row(window.y) / TILE, ty1 = (frame.row(window.y) + window.h - 1) / TILE;
+
+    zones_checked++;
+    for (int ty = ty0; ty <= ty1; ty++)
+        for (int tx = tx0; tx <= tx1; tx++)
+            if (dirty[ty * tiles_x + tx])
+                return true;
+    zones_skipped++;
+    return false;
+}
+
+void TileDetector::print_stats() const
+{
+    printf("===== TUILES : %d x %d de %d px =====\n", tiles_x, tiles_y, TILE);
+    if (tiles_checked)
+        printf("tuiles modifiées %llu / %llu (%.1f%%)\n", (unsigned long long)tiles_dirty,
+               (unsigned long long)tiles_checked, 100.0 * tiles_dirty / tiles_checked);
+    if (zones_checked)
+        printf("zones ignorées %llu / %llu (%.1f%%)\n", (unsigned long long)zones_skipped,
+               (unsigned long long)zones_checked, 100.0 * zones_skipped / zones_checked);
+}
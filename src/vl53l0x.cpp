@@ -40,9 +40,159 @@ unsigned int millis()
 // PLL_period_ps = 1655; macro_period_vclks = 2304
 #define calcMacroPeriod(vcsel_period_pclks) ((((uint32_t)2304 * (vcsel_period_pclks) * 1655) + 500) / 1000)
 
+// Register sequences //////////////////////////////////////////////////////////
+
+// DefaultTuningSettings from vl53l0x_tuning.h
+// (VL53L0X_load_tuning_settings()), written as one batched sequence
+static constexpr RegWrite TUNING_SETTINGS[] = {
+    {0xFF, 0x01},
+    {0x00, 0x00},
+
+    {0xFF, 0x00},
+    {0x09, 0x00},
+    {0x10, 0x00},
+    {0x11, 0x00},
+
+    {0x24, 0x01},
+    {0x25, 0xFF},
+    {0x75, 0x00},
+
+    {0xFF, 0x01},
+    {0x4E, 0x2C},
+    {0x48, 0x00},
+    {0x30, 0x20},
+
+    {0xFF, 0x00},
+    {0x30, 0x09},
+    {0x54, 0x00},
+    {0x31, 0x04},
+    {0x32, 0x03},
+    {0x40, 0x83},
+    {0x46, 0x25},
+    {0x60, 0x00},
+    {0x27, 0x00},
+    {0x50, 0x06},
+    {0x51, 0x00},
+    {0x52, 0x96},
+    {0x56, 0x08},
+    {0x57, 0x30},
+    {0x61, 0x00},
+    {0x62, 0x00},
+    {0x64, 0x00},
+    {0x65, 0x00},
+    {0x66, 0xA0},
+
+    {0xFF, 0x01},
+    {0x22, 0x32},
+    {0x47, 0x14},
+    {0x49, 0xFF},
+    {0x4A, 0x00},
+
+    {0xFF, 0x00},
+    {0x7A, 0x0A},
+    {0x7B, 0x00},
+    {0x78, 0x21},
+
+    {0xFF, 0x01},
+    {0x23, 0x34},
+    {0x42, 0x00},
+    {0x44, 0xFF},
+    {0x45, 0x26},
+    {0x46, 0x05},
+    {0x40, 0x40},
+    {0x0E, 0x06},
+    {0x20, 0x1A},
+    {0x43, 0x40},
+
+    {0xFF, 0x00},
+    {0x34, 0x03},
+    {0x35, 0x44},
+
+    {0xFF, 0x01},
+    {0x31, 0x04},
+    {0x4B, 0x09},
+    {0x4C, 0x05},
+    {0x4D, 0x04},
+
+    {0xFF, 0x00},
+    {0x44, 0x00},
+    {0x45, 0x20},
+    {0x47, 0x08},
+    {0x48, 0x28},
+    {0x67, 0x00},
+    {0x70, 0x04},
+    {0x71, 0x01},
+    {0x72, 0xFE},
+    {0x76, 0x00},
+    {0x77, 0x00},
+
+    {0xFF, 0x01},
+    {0x0D, 0x01},
+
+    {0xFF, 0x00},
+    {0x80, 0x01},
+    {0x01, 0xF8},
+
+    {0xFF, 0x01},
+    {0x8E, 0x01},
+    {0x00, 0x01},
+    {0xFF, 0x00},
+    {0x80, 0x00},
+};
+static constexpr auto TUNING_SEQUENCE = compile_sequence(TUNING_SETTINGS);
+static_assert(TUNING_SEQUENCE.batches() <= 2, "tuning settings should fit in two I2C_RDWR transfers");
+
+// VL53L0X_set_reference_spads() register setup (before the SPAD map itself)
+static constexpr RegWrite REF_SPAD_SETUP[] = {
+    {0xFF, 0x01},
+    {DYNAMIC_SPAD_REF_EN_START_OFFSET, 0x00},
+    {DYNAMIC_SPAD_NUM_REQUESTED_REF_SPAD, 0x2C},
+    {0xFF, 0x00},
+    {GLOBAL_CONFIG_REF_EN_START_SELECT, 0xB4},
+};
+static constexpr auto REF_SPAD_SEQUENCE = compile_sequence(REF_SPAD_SETUP);
+
+// Final range VCSEL period specific settings, from VL53L0X_set_vcsel_pulse_period()
+static constexpr RegWrite FINAL_RANGE_VCSEL_8[] = {
+    {FINAL_RANGE_CONFIG_VALID_PHASE_HIGH, 0x10},
+    {FINAL_RANGE_CONFIG_VALID_PHASE_LOW, 0x08},
+    {GLOBAL_CONFIG_VCSEL_WIDTH, 0x02},
+    {ALGO_PHASECAL_CONFIG_TIMEOUT, 0x0C},
+    {0xFF, 0x01},
+    {ALGO_PHASECAL_LIM, 0x30},
+    {0xFF, 0x00},
+};
+static constexpr RegWrite FINAL_RANGE_VCSEL_10[] = {
+    {FINAL_RANGE_CONFIG_VALID_PHASE_HIGH, 0x28},
+    {FINAL_RANGE_CONFIG_VALID_PHASE_LOW, 0x08},
+    {GLOBAL_CONFIG_VCSEL_WIDTH, 0x03},
+    {ALGO_PHASECAL_CONFIG_TIMEOUT, 0x09},
+    {0xFF, 0x01},
+    {ALGO_PHASECAL_LIM, 0x20},
+    {0xFF, 0x00},
+};
+static constexpr RegWrite FINAL_RANGE_VCSEL_12[] = {
+    {FINAL_RANGE_CONFIG_VALID_PHASE_HIGH, 0x38},
+    {FINAL_RANGE_CONFIG_VALID_PHASE_LOW, 0x08},
+    {GLOBAL_CONFIG_VCSEL_WIDTH, 0x03},
+    {ALGO_PHASECAL_CONFIG_TIMEOUT, 0x08},
+    {0xFF, 0x01},
+    {ALGO_PHASECAL_LIM, 0x20},
+    {0xFF, 0x00},
+};
+static constexpr RegWrite FINAL_RANGE_VCSEL_14[] = {
+    {FINAL_RANGE_CONFIG_VALID_PHASE_HIGH, 0x48},
+    {FINAL_RANGE_CONFIG_VALID_PHASE_LOW, 0x08},
+    {GLOBAL_CONFIG_VCSEL_WIDTH, 0x03},
+    {ALGO_PHASECAL_CONFIG_TIMEOUT, 0x07},
+    {0xFF, 0x01},
+    {ALGO_PHASECAL_LIM, 0x20},
+    {0xFF, 0x00},
+};
+
 // Constructors ////////////////////////////////////////////////////////////////
 
-VL53L0X::VL53L0X(uint8_t address) : I2C_slave(address)
+VL53L0X::VL53L0X(uint8_t address, const char *bus_path) : I2C_slave(address, I2C_PRIO_SENSOR, bus_path), init_duration_ms(0)
 {
 }
 
@@ -56,8 +206,14 @@ VL53L0X::VL53L0X(uint8_t address) : I2C_slave(address)
 // enough unless a cover glass is added.
 // If io_2v8 (optional) is true or not given, the sensor is configured for 2V8
 // mode.
-bool VL53L0X::init(bool io_2v8)
+// If calibration_file is given, the result of the SPAD info read, the reference
+// SPAD map, the VHV/phase calibration and stop_variable are taken from it when
+// the entry matches this module (part UID and address), and the file is updated
+// otherwise. recalibrate forces the full sequence even on a matching entry.
+bool VL53L0X::init(bool io_2v8, const char *calibration_file, bool recalibrate)
 {
+  uint32_t start_ms = millis();
+
   // check model ID register (value specified in datasheet)
   if (readReg(IDENTIFICATION_MODEL_ID) != 0xEE)
   {
@@ -76,14 +232,34 @@ bool VL53L0X::init(bool io_2v8)
   // "Set I2C standard mode"
   writeReg(0x88, 0x00);
 
-  writeReg(0x80, 0x01);
-  writeReg(0xFF, 0x01);
-  writeReg(0x00, 0x00);
-  stop_variable = readReg(0x91);
-  printf("DEBUG: stop_variable lue = 0x%02X\n", stop_variable);
-  writeReg(0x00, 0x01);
-  writeReg(0xFF, 0x00);
-  writeReg(0x80, 0x00);
+  // recherche d'une calibration déjà faite pour ce module
+  VL53L0XCalibration cal = {};
+  bool cached = false;
+  if (calibration_file)
+  {
+    if (!getPartUid(&cal.uid))
+    {
+      return false;
+    }
+    cached = !recalibrate && loadCalibration(calibration_file, cal.uid, &cal) && cal.address == get_address();
+    cal.address = get_address();
+  }
+
+  if (cached)
+  {
+    stop_variable = cal.stop_variable;
+  }
+  else
+  {
+    writeReg(0x80, 0x01);
+    writeReg(0xFF, 0x01);
+    writeReg(0x00, 0x00);
+    stop_variable = readReg(0x91);
+    printf("DEBUG: stop_variable lue = 0x%02X\n", stop_variable);
+    writeReg(0x00, 0x01);
+    writeReg(0xFF, 0x00);
+    writeReg(0x80, 0x00);
+  }
 
   // disable SIGNAL_RATE_MSRC (bit 1) and SIGNAL_RATE_PRE_RANGE (bit 4) limit checks
   writeReg(MSRC_CONFIG_CONTROL, readReg(MSRC_CONFIG_CONTROL) | 0x12);
@@ -97,41 +273,43 @@ bool VL53L0X::init(bool io_2v8)
 
   // VL53L0X_StaticInit() begin
 
-  uint8_t spad_count;
-  bool spad_type_is_aperture;
-  if (!getSpadInfo(&spad_count, &spad_type_is_aperture))
+  uint8_t *ref_spad_map = cal.ref_spad_map;
+  if (!cached)
   {
-    return false;
-  }
+    bool spad_type_is_aperture;
+    if (!getSpadInfo(&cal.spad_count, &spad_type_is_aperture))
+    {
+      return false;
+    }
+    cal.spad_type_is_aperture = spad_type_is_aperture;
 
-  // The SPAD map (RefGoodSpadMap) is read by VL53L0X_get_info_from_device() in
-  // the API, but the same data seems to be more easily readable from
-  // GLOBAL_CONFIG_SPAD_ENABLES_REF_0 through _6, so read it from there
-  uint8_t ref_spad_map[6];
-  readMulti(GLOBAL_CONFIG_SPAD_ENABLES_REF_0, ref_spad_map, 6);
+    // The SPAD map (RefGoodSpadMap) is read by VL53L0X_get_info_from_device() in
+    // the API, but the same data seems to be more easily readable from
+    // GLOBAL_CONFIG_SPAD_ENABLES_REF_0 through _6, so read it from there
+    readMulti(GLOBAL_CONFIG_SPAD_ENABLES_REF_0, ref_spad_map, 6);
+  }
 
   // -- VL53L0X_set_reference_spads() begin (assume NVM values are valid)
 
-  writeReg(0xFF, 0x01);
-  writeReg(DYNAMIC_SPAD_REF_EN_START_OFFSET, 0x00);
-  writeReg(DYNAMIC_SPAD_NUM_REQUESTED_REF_SPAD, 0x2C);
-  writeReg(0xFF, 0x00);
-  writeReg(GLOBAL_CONFIG_REF_EN_START_SELECT, 0xB4);
-
-  uint8_t first_spad_to_enable = spad_type_is_aperture ? 12 : 0; // 12 is the first aperture spad
-  uint8_t spads_enabled = 0;
+  write(REF_SPAD_SEQUENCE);
 
-  for (uint8_t i = 0; i < 48; i++)
+  if (!cached)
   {
-    if (i < first_spad_to_enable || spads_enabled == spad_count)
-    {
-      // This bit is lower than the first one that should be enabled, or
-      // (reference_spad_count) bits have already been enabled, so zero this bit
-      ref_spad_map[i / 8] &= ~(1 << (i % 8));
-    }
-    else if ((ref_spad_map[i / 8] >> (i % 8)) & 0x1)
+    uint8_t first_spad_to_enable = cal.spad_type_is_aperture ? 12 : 0; // 12 is the first aperture spad
+    uint8_t spads_enabled = 0;
+
+    for (uint8_t i = 0; i < 48; i++)
     {
-      spads_enabled++;
+      if (i < first_spad_to_enable || spads_enabled == cal.spad_count)
+      {
+        // This bit is lower than the first one that should be enabled, or
+        // (reference_spad_count) bits have already been enabled, so zero this bit
+        ref_spad_map[i / 8] &= ~(1 << (i % 8));
+      }
+      else if ((ref_spad_map[i / 8] >> (i % 8)) & 0x1)
+      {
+        spads_enabled++;
+      }
     }
   }
 
@@ -140,101 +318,8 @@ bool VL53L0X::init(bool io_2v8)
   // -- VL53L0X_set_reference_spads() end
 
   // -- VL53L0X_load_tuning_settings() begin
-  // DefaultTuningSettings from vl53l0x_tuning.h
-
-  writeReg(0xFF, 0x01);
-  writeReg(0x00, 0x00);
-
-  writeReg(0xFF, 0x00);
-  writeReg(0x09, 0x00);
-  writeReg(0x10, 0x00);
-  writeReg(0x11, 0x00);
 
-  writeReg(0x24, 0x01);
-  writeReg(0x25, 0xFF);
-  writeReg(0x75, 0x00);
-
-  writeReg(0xFF, 0x01);
-  writeReg(0x4E, 0x2C);
-  writeReg(0x48, 0x00);
-  writeReg(0x30, 0x20);
-
-  writeReg(0xFF, 0x00);
-  writeReg(0x30, 0x09);
-  writeReg(0x54, 0x00);
-  writeReg(0x31, 0x04);
-  writeReg(0x32, 0x03);
-  writeReg(0x40, 0x83);
-  writeReg(0x46, 0x25);
-  writeReg(0x60, 0x00);
-  writeReg(0x27, 0x00);
-  writeReg(0x50, 0x06);
-  writeReg(0x51, 0x00);
-  writeReg(0x52, 0x96);
-  writeReg(0x56, 0x08);
-  writeReg(0x57, 0x30);
-  writeReg(0x61, 0x00);
-  writeReg(0x62, 0x00);
-  writeReg(0x64, 0x00);
-  writeReg(0x65, 0x00);
-  writeReg(0x66, 0xA0);
-
-  writeReg(0xFF, 0x01);
-  writeReg(0x22, 0x32);
-  writeReg(0x47, 0x14);
-  writeReg(0x49, 0xFF);
-  writeReg(0x4A, 0x00);
-
-  writeReg(0xFF, 0x00);
-  writeReg(0x7A, 0x0A);
-  writeReg(0x7B, 0x00);
-  writeReg(0x78, 0x21);
-
-  writeReg(0xFF, 0x01);
-  writeReg(0x23, 0x34);
-  writeReg(0x42, 0x00);
-  writeReg(0x44, 0xFF);
-  writeReg(0x45, 0x26);
-  writeReg(0x46, 0x05);
-  writeReg(0x40, 0x40);
-  writeReg(0x0E, 0x06);
-  writeReg(0x20, 0x1A);
-  writeReg(0x43, 0x40);
-
-  writeReg(0xFF, 0x00);
-  writeReg(0x34, 0x03);
-  writeReg(0x35, 0x44);
-
-  writeReg(0xFF, 0x01);
-  writeReg(0x31, 0x04);
-  writeReg(0x4B, 0x09);
-  writeReg(0x4C, 0x05);
-  writeReg(0x4D, 0x04);
-
-  writeReg(0xFF, 0x00);
-  writeReg(0x44, 0x00);
-  writeReg(0x45, 0x20);
-  writeReg(0x47, 0x08);
-  writeReg(0x48, 0x28);
-  writeReg(0x67, 0x00);
-  writeReg(0x70, 0x04);
-  writeReg(0x71, 0x01);
-  writeReg(0x72, 0xFE);
-  writeReg(0x76, 0x00);
-  writeReg(0x77, 0x00);
-
-  writeReg(0xFF, 0x01);
-  writeReg(0x0D, 0x01);
-
-  writeReg(0xFF, 0x00);
-  writeReg(0x80, 0x01);
-  writeReg(0x01, 0xF8);
-
-  writeReg(0xFF, 0x01);
-  writeReg(0x8E, 0x01);
-  writeReg(0x00, 0x01);
-  writeReg(0xFF, 0x00);
-  writeReg(0x80, 0x00);
+  write(TUNING_SEQUENCE);
 
   // -- VL53L0X_load_tuning_settings() end
 
@@ -263,32 +348,53 @@ bool VL53L0X::init(bool io_2v8)
 
   // VL53L0X_StaticInit() end
 
-  // VL53L0X_PerformRefCalibration() begin (VL53L0X_perform_ref_calibration())
-
-  // -- VL53L0X_perform_vhv_calibration() begin
-
-  writeReg(SYSTEM_SEQUENCE_CONFIG, 0x01);
-  if (!performSingleRefCalibration(0x40))
+  if (cached)
   {
-    return false;
+    // VL53L0X_SetRefCalibration(): réécrit les valeurs VHV/phase sauvegardées
+    // au lieu de relancer les deux mesures de calibration
+    setRefCalibration(cal.vhv_settings, cal.phase_cal);
   }
+  else
+  {
+    // VL53L0X_PerformRefCalibration() begin (VL53L0X_perform_ref_calibration())
 
-  // -- VL53L0X_perform_vhv_calibration() end
+    // -- VL53L0X_perform_vhv_calibration() begin
 
-  // -- VL53L0X_perform_phase_calibration() begin
+    writeReg(SYSTEM_SEQUENCE_CONFIG, 0x01);
+    if (!performSingleRefCalibration(0x40))
+    {
+      return false;
+    }
 
-  writeReg(SYSTEM_SEQUENCE_CONFIG, 0x02);
-  if (!performSingleRefCalibration(0x00))
-  {
-    return false;
-  }
+    // -- VL53L0X_perform_vhv_calibration() end
 
-  // -- VL53L0X_perform_phase_calibration() end
+    // -- VL53L0X_perform_phase_calibration() begin
 
-  // "restore the previous Sequence Config"
-  writeReg(SYSTEM_SEQUENCE_CONFIG, 0xE8);
+    writeReg(SYSTEM_SEQUENCE_CONFIG, 0x02);
+    if (!performSingleRefCalibration(0x00))
+    {
+      return false;
+    }
 
-  // VL53L0X_PerformRefCalibration() end
+    // -- VL53L0X_perform_phase_calibration() end
+
+    // "restore the previous Sequence Config"
+    writeReg(SYSTEM_SEQUENCE_CONFIG, 0xE8);
+
+    // VL53L0X_PerformRefCalibration() end
+
+    if (calibration_file)
+    {
+      cal.stop_variable = stop_variable;
+      getRefCalibration(&cal.vhv_settings, &cal.phase_cal);
+      if (!saveCalibration(calibration_file, &cal))
+        fprintf(stderr, "VL53L0X 0x%02X : impossible d'écrire %s\n", get_address(), calibration_file);
+    }
+  }
+
+  init_duration_ms = millis() - start_ms;
+  printf("VL53L0X 0x%02X : init en %u ms (calibration %s)\n",
+         get_address(), init_duration_ms, cached ? "en cache" : "complète");
 
   return true;
 }
@@ -629,43 +735,19 @@ bool VL53L0X::setVcselPulsePeriod(vcselPeriodType type, uint8_t period_pclks)
     switch (period_pclks)
     {
     case 8:
-      writeReg(FINAL_RANGE_CONFIG_VALID_PHASE_HIGH, 0x10);
-      writeReg(FINAL_RANGE_CONFIG_VALID_PHASE_LOW, 0x08);
-      writeReg(GLOBAL_CONFIG_VCSEL_WIDTH, 0x02);
-      writeReg(ALGO_PHASECAL_CONFIG_TIMEOUT, 0x0C);
-      writeReg(0xFF, 0x01);
-      writeReg(ALGO_PHASECAL_LIM, 0x30);
-      writeReg(0xFF, 0x00);
+      write(FINAL_RANGE_VCSEL_8, sizeof(FINAL_RANGE_VCSEL_8) / sizeof(RegWrite));
       break;
 
     case 10:
-      writeReg(FINAL_RANGE_CONFIG_VALID_PHASE_HIGH, 0x28);
-      writeReg(FINAL_RANGE_CONFIG_VALID_PHASE_LOW, 0x08);
-      writeReg(GLOBAL_CONFIG_VCSEL_WIDTH, 0x03);
-      writeReg(ALGO_PHASECAL_CONFIG_TIMEOUT, 0x09);
-      writeReg(0xFF, 0x01);
-      writeReg(ALGO_PHASECAL_LIM, 0x20);
-      writeReg(0xFF, 0x00);
+      write(FINAL_RANGE_VCSEL_10, sizeof(FINAL_RANGE_VCSEL_10) / sizeof(RegWrite));
       break;
 
     case 12:
-      writeReg(FINAL_RANGE_CONFIG_VALID_PHASE_HIGH, 0x38);
-      writeReg(FINAL_RANGE_CONFIG_VALID_PHASE_LOW, 0x08);
-      writeReg(GLOBAL_CONFIG_VCSEL_WIDTH, 0x03);
-      writeReg(ALGO_PHASECAL_CONFIG_TIMEOUT, 0x08);
-      writeReg(0xFF, 0x01);
-      writeReg(ALGO_PHASECAL_LIM, 0x20);
-      writeReg(0xFF, 0x00);
+      write(FINAL_RANGE_VCSEL_12, sizeof(FINAL_RANGE_VCSEL_12) / sizeof(RegWrite));
       break;
 
     case 14:
-      writeReg(FINAL_RANGE_CONFIG_VALID_PHASE_HIGH, 0x48);
-      writeReg(FINAL_RANGE_CONFIG_VALID_PHASE_LOW, 0x08);
-      writeReg(GLOBAL_CONFIG_VCSEL_WIDTH, 0x03);
-      writeReg(ALGO_PHASECAL_CONFIG_TIMEOUT, 0x07);
-      writeReg(0xFF, 0x01);
-      writeReg(ALGO_PHASECAL_LIM, 0x20);
-      writeReg(0xFF, 0x00);
+      write(FINAL_RANGE_VCSEL_14, sizeof(FINAL_RANGE_VCSEL_14) / sizeof(RegWrite));
       break;
 
     default:
@@ -748,13 +830,16 @@ uint8_t VL53L0X::getVcselPulsePeriod(vcselPeriodType type)
 // based on VL53L0X_StartMeasurement()
 void VL53L0X::startContinuous(uint32_t period_ms)
 {
-  writeReg(0x80, 0x01);
-  writeReg(0xFF, 0x01);
-  writeReg(0x00, 0x00);
-  writeReg(0x91, stop_variable);
-  writeReg(0x00, 0x01);
-  writeReg(0xFF, 0x00);
-  writeReg(0x80, 0x00);
+  RegWrite const restore_stop_variable[] = {
+      {0x80, 0x01},
+      {0xFF, 0x01},
+      {0x00, 0x00},
+      {0x91, stop_variable},
+      {0x00, 0x01},
+      {0xFF, 0x00},
+      {0x80, 0x00},
+  };
+  write(restore_stop_variable, sizeof(restore_stop_variable) / sizeof(RegWrite));
 
   if (period_ms != 0)
   {
@@ -786,13 +871,15 @@ void VL53L0X::startContinuous(uint32_t period_ms)
 // based on VL53L0X_StopMeasurement()
 void VL53L0X::stopContinuous()
 {
-  writeReg(SYSRANGE_START, 0x01); // VL53L0X_REG_SYSRANGE_MODE_SINGLESHOT
-
-  writeReg(0xFF, 0x01);
-  writeReg(0x00, 0x00);
-  writeReg(0x91, 0x00);
-  writeReg(0x00, 0x01);
-  writeReg(0xFF, 0x00);
+  static constexpr RegWrite STOP_SEQUENCE[] = {
+      {SYSRANGE_START, 0x01}, // VL53L0X_REG_SYSRANGE_MODE_SINGLESHOT
+      {0xFF, 0x01},
+      {0x00, 0x00},
+      {0x91, 0x00},
+      {0x00, 0x01},
+      {0xFF, 0x00},
+  };
+  write(STOP_SEQUENCE, sizeof(STOP_SEQUENCE) / sizeof(RegWrite));
 }
 
 // Returns a range reading in millimeters when continuous mode is active
@@ -826,20 +913,52 @@ uint16_t VL53L0X::readRangeContinuousMillimeters()
   return range;
 }
 
+// Non-blocking variant of readRangeContinuousMillimeters(): one status read,
+// and the result is only read and cleared when a measurement is ready
+bool VL53L0X::readRangeIfReady(uint16_t *range, uint8_t *status)
+{
+  uint8_t interrupt;
+  if (!read(RESULT_INTERRUPT_STATUS, &interrupt))
+  {
+    did_timeout = true;
+    return false;
+  }
+  if ((interrupt & 0x07) == 0)
+    return false;
+
+  // état de la mesure (RESULT_RANGE_STATUS) et distance (0x1E) dans la même lecture
+  // quand l'état est demandé, sinon la distance seule
+  uint8_t buffer[12];
+  bool ok = status ? read(RESULT_RANGE_STATUS, buffer, (uint32_t)sizeof(buffer))
+                   : read(0x1E, &buffer[10], (uint32_t)2);
+  if (!ok)
+  {
+    did_timeout = true;
+    return false;
+  }
+  *range = (uint16_t)((buffer[10] << 8) | buffer[11]);
+  if (status)
+    *status = (buffer[0] >> 3) & 0x0F;
+  writeReg(SYSTEM_INTERRUPT_CLEAR, 0x01);
+  return true;
+}
+
 // Performs a single-shot range measurement and returns the reading in
 // millimeters
 // based on VL53L0X_PerformSingleRangingMeasurement()
 uint16_t VL53L0X::readRangeSingleMillimeters()
 {
-  writeReg(0x80, 0x01);
-  writeReg(0xFF, 0x01);
-  writeReg(0x00, 0x00);
-  writeReg(0x91, stop_variable);
-  writeReg(0x00, 0x01);
-  writeReg(0xFF, 0x00);
-  writeReg(0x80, 0x00);
-
-  writeReg(SYSRANGE_START, 0x01);
+  RegWrite const start[] = {
+      {0x80, 0x01},
+      {0xFF, 0x01},
+      {0x00, 0x00},
+      {0x91, stop_variable},
+      {0x00, 0x01},
+      {0xFF, 0x00},
+      {0x80, 0x00},
+      {SYSRANGE_START, 0x01},
+  };
+  write(start, sizeof(start) / sizeof(RegWrite));
 
   // "Wait until start bit has been cleared"
   startTimeout();
@@ -864,6 +983,82 @@ bool VL53L0X::timeoutOccurred()
   return tmp;
 }
 
+// Calibration cache //////////////////////////////////////////////////////////
+
+// Le fichier contient un entête (magic, version, nombre d'entrées) suivi des
+// entrées VL53L0XCalibration, une par module. Il est spécifique à la machine
+// (pas de conversion d'endianness).
+
+// Cherche l'entrée du module uid dans le fichier path
+bool VL53L0X::loadCalibration(const char *path, uint64_t uid, VL53L0XCalibration *cal)
+{
+  FILE *f = fopen(path, "rb");
+  if (!f)
+    return false;
+
+  uint32_t header[3];
+  bool found = false;
+  if (fread(header, sizeof(header), 1, f) == 1 &&
+      header[0] == CALIBRATION_MAGIC && header[1] == CALIBRATION_VERSION)
+  {
+    VL53L0XCalibration entry;
+    for (uint32_t i = 0; i < header[2] && fread(&entry, sizeof(entry), 1, f) == 1; i++)
+    {
+      if (entry.uid == uid)
+      {
+        *cal = entry;
+        found = true;
+        break;
+      }
+    }
+  }
+  fclose(f);
+  return found;
+}
+
+// Ajoute ou remplace l'entrée du module cal->uid dans le fichier path.
+// Le fichier est réécrit dans un fichier temporaire puis renommé, pour ne
+// jamais laisser un cache à moitié écrit.
+bool VL53L0X::saveCalibration(const char *path, VL53L0XCalibration const *cal)
+{
+  // Nombre max d'entrées conservées
+  static constexpr uint32_t MAX_ENTRIES = 64;
+  VL53L0XCalibration entries[MAX_ENTRIES];
+  uint32_t count = 0;
+
+  FILE *f = fopen(path, "rb");
+  if (f)
+  {
+    uint32_t header[3];
+    if (fread(header, sizeof(header), 1, f) == 1 &&
+        header[0] == CALIBRATION_MAGIC && header[1] == CALIBRATION_VERSION)
+    {
+      VL53L0XCalibration entry;
+      for (uint32_t i = 0; i < header[2] && count < MAX_ENTRIES - 1 &&
+                           fread(&entry, sizeof(entry), 1, f) == 1;
+           i++)
+      {
+        if (entry.uid != cal->uid)
+          entries[count++] = entry;
+      }
+    }
+    fclose(f);
+  }
+  entries[count++] = *cal;
+
+  char tmp_path[256];
+  snprintf(tmp_path, sizeof(tmp_path), "%s.tmp", path);
+  f = fopen(tmp_path, "wb");
+  if (!f)
+    return false;
+
+  uint32_t header[3] = {CALIBRATION_MAGIC, CALIBRATION_VERSION, count};
+  bool ok = fwrite(header, sizeof(header), 1, f) == 1 &&
+            fwrite(entries, sizeof(VL53L0XCalibration), count, f) == count;
+  ok = (fclose(f) == 0) && ok;
+  return ok && rename(tmp_path, path) == 0;
+}
+
 // Private Methods /////////////////////////////////////////////////////////////
 
 // Get reference SPAD (single photon avalanche diode) count and type
@@ -912,6 +1107,86 @@ bool VL53L0X::getSpadInfo(uint8_t *count, bool *type_is_aperture)
   return true;
 }
 
+// Get the 64-bit part UID from NVM
+// based on VL53L0X_get_info_from_device() (option 2), used to key the
+// calibration cache
+bool VL53L0X::getPartUid(uint64_t *uid)
+{
+  uint8_t const index[2] = {0x7B, 0x7C}; // PartUIDUpper, PartUIDLower
+  uint32_t part[2];
+
+  writeReg(0x80, 0x01);
+  writeReg(0xFF, 0x01);
+  writeReg(0x00, 0x00);
+
+  writeReg(0xFF, 0x06);
+  writeReg(0x83, readReg(0x83) | 0x04);
+  writeReg(0xFF, 0x07);
+  writeReg(0x81, 0x01);
+
+  writeReg(0x80, 0x01);
+
+  for (int i = 0; i < 2; i++)
+  {
+    writeReg(0x94, index[i]);
+    writeReg(0x83, 0x00);
+    startTimeout();
+    while (readReg(0x83) == 0x00)
+    {
+      if (checkTimeoutExpired())
+      {
+        return false;
+      }
+    }
+    writeReg(0x83, 0x01);
+    part[i] = readReg32Bit(0x90);
+  }
+
+  writeReg(0x81, 0x00);
+  writeReg(0xFF, 0x06);
+  writeReg(0x83, readReg(0x83) & ~0x04);
+  writeReg(0xFF, 0x01);
+  writeReg(0x00, 0x01);
+
+  writeReg(0xFF, 0x00);
+  writeReg(0x80, 0x00);
+
+  *uid = ((uint64_t)part[0] << 32) | part[1];
+  return true;
+}
+
+// Read back the VHV and phase calibration results
+// based on VL53L0X_ref_calibration_io() (read_not_write = 1)
+void VL53L0X::getRefCalibration(uint8_t *vhv_settings, uint8_t *phase_cal)
+{
+  writeReg(0xFF, 0x01);
+  writeReg(0x00, 0x00);
+  writeReg(0xFF, 0x00);
+
+  *vhv_settings = readReg(0xCB);
+  *phase_cal = readReg(0xEE);
+
+  writeReg(0xFF, 0x01);
+  writeReg(0x00, 0x01);
+  writeReg(0xFF, 0x00);
+}
+
+// Restore VHV and phase calibration results
+// based on VL53L0X_ref_calibration_io() (read_not_write = 0)
+void VL53L0X::setRefCalibration(uint8_t vhv_settings, uint8_t phase_cal)
+{
+  writeReg(0xFF, 0x01);
+  writeReg(0x00, 0x00);
+  writeReg(0xFF, 0x00);
+
+  writeReg(0xCB, vhv_settings);
+  writeReg(0xEE, (readReg(0xEE) & 0x80) | phase_cal);
+
+  writeReg(0xFF, 0x01);
+  writeReg(0x00, 0x01);
+  writeReg(0xFF, 0x00);
+}
+
 // Get sequence step enables
 // based on VL53L0X_GetSequenceStepEnables()
 void VL53L0X::getSequenceStepEnables(SequenceStepEnables *enables)
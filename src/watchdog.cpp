@@ -0,0 +1,85 @@
+#include "watchdog.hpp"
+#include <cstdio>
+#include <ctime>
+#include <unistd.h>
+
+// temps monotone en ms
+static uint64_t now_ms()
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000 + ts.tv_nsec / 1000000;
+}
+
+Watchdog::Watchdog(uint32_t deadline_ms, std::function<void()> on_stall)
+    : deadline_ms(deadline_ms), on_stall(on_stall)
+{
+}
+
+Watchdog::~Watchdog()
+{
+    stop();
+}
+
+void Watchdog::start()
+{
+    if (running)
+        return;
+    last_beat_ms = now_ms();
+    running = true;
+    worker = std::thread(&Watchdog::loop, this);
+}
+
+void Watchdog::stop()
+{
+    running = false;
+    if (worker.joinable())
+        worker.join();
+}
+
+void Watchdog::heartbeat()
+{
+    uint64_t now = now_ms();
+    uint64_t previous = last_beat_ms.exchange(now);
+
+    // fin d'un blocage : durée depuis le dernier battement avant le blocage
+    if (stalled.exchange(false))
+    {
+        uint64_t duration = now - previous;
+        std::lock_guard<std::mutex> lock(stats_mutex);
+        total_stall_ms += duration;
+        if (duration > max_stall_ms)
+            max_stall_ms = duration;
+        fprintf(stderr, "[WATCHDOG] Boucle de commande reprise après %llu ms\n", (unsigned long long)duration);
+    }
+}
+
+void Watchdog::loop()
+{
+    // vérification 4 fois par échéance : réaction en au plus 1.25 * deadline_ms
+    const useconds_t check_us = deadline_ms * 1000 / 4;
+
+    while (running)
+    {
+        usleep(check_us);
+        // battement lu avant l'heure : un heartbeat concurrent ne peut pas le rendre
+        // plus récent que now, et l'écart signé reste négatif au pire
+        uint64_t last = last_beat_ms.load();
+        int64_t silent_ms = (int64_t)(now_ms() - last);
+        if (!stalled && silent_ms > (int64_t)deadline_ms && !stalled.exchange(true))
+        {
+            stalls++;
+            on_stall();
+        }
+    }
+}
+
+void Watchdog::print_stats() const
+{
+    std::lock_guard<std::mutex> lock(stats_mutex);
+    uint32_t n = stalls;
+    printf("===== WATCHDOG : %u blocage(s) =====\n", n);
+    if (n)
+        printf("durée totale %llu ms, max %llu ms, moyenne %llu ms\n", (unsigned long long)total_stall_ms,
+               (unsigned long long)max_stall_ms, (unsigned long long)(total_stall_ms / n));
+}
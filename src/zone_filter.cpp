@@ -0,0 +1,115 @@
+#include "zone_filter.hpp"
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+
+ZoneFilter::ZoneFilter(int zones, ZoneFilterMode mode, int ring_size, float alpha)
+    : zones(zones), mode(mode), ring_size(std::clamp(ring_size | 1, 1, MAX_RING)), alpha(alpha),
+      ring(this->ring_size * zones), sorted(this->ring_size * zones), value(zones), speed(zones)
+{
+}
+
+void ZoneFilter::set_one_euro(float min_cutoff, float beta, float d_cutoff)
+{
+    this->min_cutoff = min_cutoff;
+    this->beta = beta;
+    this->d_cutoff = d_cutoff;
+}
+
+void ZoneFilter::reset()
+{
+    head = 0;
+    primed = false;
+}
+
+// coefficient d'un passe-bas du premier ordre de fréquence de coupure cutoff
+static inline float smoothing(float cutoff, float dt)
+{
+    float tau = 1.0f / (2 * (float)M_PI * cutoff);
+    return 1.0f / (1.0f + tau / dt);
+}
+
+float ZoneFilter::group_delay(int zone, float dt) const
+{
+    switch (mode)
+    {
+    case FILTER_MEDIAN:
+        // médiane d'une rampe : la valeur du milieu du ring
+        return (ring_size - 1) / 2 * dt;
+    case FILTER_EMA:
+        return (1 - alpha) / alpha * dt;
+    case FILTER_ONE_EURO:
+        // passe-bas du premier ordre : (1 - a) / a * dt = tau, à la coupure du dernier update()
+        return 1.0f / (2 * (float)M_PI * (min_cutoff + beta * std::abs(speed[zone])));
+    default:
+        return 0;
+    }
+}
+
+void ZoneFilter::update(float const *input, float *output, float dt)
+{
+    if (mode == FILTER_NONE)
+    {
+        memcpy(output, input, zones * sizeof(float));
+        return;
+    }
+
+    // première mesure : reprise telle quelle, et copiée dans tout le ring
+    if (!primed)
+    {
+        for (int k = 0; k < ring_size; k++)
+            memcpy(&ring[k * zones], input, zones * sizeof(float));
+        memcpy(value.data(), input, zones * sizeof(float));
+        std::fill(speed.begin(), speed.end(), 0.0f);
+        memcpy(output, input, zones * sizeof(float));
+        head = 1 % ring_size;
+        primed = true;
+        return;
+    }
+    dt = std::max(dt, 1e-3f);
+
+    switch (mode)
+    {
+    case FILTER_MEDIAN:
+    {
+        memcpy(&ring[head * zones], input, zones * sizeof(float));
+        head = (head + 1) % ring_size;
+
+        // tri par transposition pair-impair des lignes : n passes de min/max sur toutes les zones
+        int n = ring_size;
+        memcpy(sorted.data(), ring.data(), n * zones * sizeof(float));
+        for (int pass = 0; pass < n; pass++)
+        {
+            for (int k = pass & 1; k + 1 < n; k += 2)
+            {
+                float *a = &sorted[k * zones], *b = &sorted[(k + 1) * zones];
+                for (int z = 0; z < zones; z++)
+                {
+                    float lo = std::min(a[z], b[z]), hi = std::max(a[z], b[z]);
+                    a[z] = lo;
+                    b[z] = hi;
+                }
+            }
+        }
+        memcpy(output, &sorted[(n / 2) * zones], zones * sizeof(float));
+        break;
+    }
+    case FILTER_EMA:
+        for (int z = 0; z < zones; z++)
+            output[z] = value[z] += alpha * (input[z] - value[z]);
+        break;
+    case FILTER_ONE_EURO:
+    {
+        float a_speed = smoothing(d_cutoff, dt);
+        for (int z = 0; z < zones; z++)
+        {
+            speed[z] += a_speed * ((input[z] - value[z]) / dt - speed[z]);
+            float a = smoothing(min_cutoff + beta * std::abs(speed[z]), dt);
+            output[z] = value[z] += a * (input[z] - value[z]);
+        }
+        break;
+    }
+    default:
+        break;
+    }
+}
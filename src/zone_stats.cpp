@@ -0,0 +1,126 @@
+#include "zone_stats.hpp"
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+
+// valeur de la loi normale pour un intervalle de confiance à 95%
+static constexpr float Z_95 = 1.96f;
+// en dessous de ce nombre d'échantillons valides, l'estimation n'est pas fiable
+static constexpr uint32_t MIN_VALID_SAMPLES = 8;
+
+ZoneStatistics::ZoneStatistics(uint16_t valid_max, float percentile)
+    : valid_max(valid_max), percentile(std::clamp(percentile, 0.0f, 100.0f)), shift(0)
+{
+    // plus petite largeur de classe pour que [0, valid_max) tienne dans l'histogramme
+    while (((valid_max - 1) >> shift) >= HIST_BINS)
+        shift++;
+}
+
+ZoneStats ZoneStatistics::gather(uint16_t const *data, PixelTable const &table)
+{
+    uint64_t sum = 0;
+    uint32_t valid = 0, total = 0;
+    uint16_t min = UINT16_MAX;
+    memset(histogram, 0, sizeof(histogram));
+
+    for (PixelRun const &run : table.runs)
+    {
+        uint16_t const *line = data + run.offset;
+        uint32_t run_sum = 0, run_valid = 0;
+
+        // somme, minimum et comptage sans branchement : boucle vectorisée par le compilateur
+        for (uint32_t x = 0; x < run.length; x++)
+        {
+            uint16_t d = line[x];
+            uint16_t ok = d < valid_max;
+            run_sum += d * ok;
+            run_valid += ok;
+            min = std::min<uint16_t>(min, ok ? d : UINT16_MAX);
+        }
+        // histogramme sur le même segment, encore dans le cache
+        for (uint32_t x = 0; x < run.length; x++)
+            if (line[x] < valid_max)
+                histogram[line[x] >> shift]++;
+        sum += run_sum;
+        valid += run_valid;
+        total += run.length;
+    }
+
+    for (size_t i = 0; i < table.offsets.size(); i++)
+    {
+        uint16_t d = data[table.offsets[i]];
+        uint32_t w = table.weights[i];
+        total += w;
+        if (d < valid_max)
+        {
+            sum += d * w;
+            valid += w;
+            min = std::min(min, d);
+            histogram[d >> shift] += w;
+        }
+    }
+
+    ZoneStats stats = {0, 0, 0, 0, 0};
+    if (total)
+        stats.valid_ratio = (float)valid / total;
+    if (!valid)
+        return stats;
+
+    stats.mean = (float)sum / valid;
+    stats.min = min;
+    stats.percentile = histogram_percentile(valid);
+    return stats;
+}
+
+ZoneStats ZoneStatistics::estimate(uint16_t const *data, SamplePattern const &pattern)
+{
+    uint32_t sum = 0, valid = 0;
+    uint64_t sum_sq = 0;
+    uint16_t min = UINT16_MAX;
+    memset(histogram, 0, sizeof(histogram));
+
+    for (uint32_t offset : pattern.offsets)
+    {
+        uint16_t d = data[offset];
+        if (d < valid_max)
+        {
+            sum += d;
+            sum_sq += (uint32_t)d * d;
+            valid++;
+            min = std::min(min, d);
+            histogram[d >> shift]++;
+        }
+    }
+
+    // intervalle infini : l'appelant doit repasser par gather()
+    ZoneStats stats = {0, 0, 0, 0, INFINITY};
+    if (!pattern.offsets.empty())
+        stats.valid_ratio = (float)valid / pattern.offsets.size();
+    if (valid < MIN_VALID_SAMPLES)
+        return stats;
+
+    stats.mean = (float)sum / valid;
+    stats.min = min;
+    stats.percentile = histogram_percentile(valid);
+    float variance = std::max(0.0f, (float)sum_sq / valid - stats.mean * stats.mean) * valid / (valid - 1);
+    stats.bound = Z_95 * std::sqrt(variance / valid);
+    return stats;
+}
+
+float ZoneStatistics::histogram_percentile(uint32_t valid) const
+{
+    // rang recherché, puis parcours des effectifs cumulés
+    float rank = percentile / 100.0f * valid;
+    uint32_t cumulated = 0;
+    for (int b = 0; b < HIST_BINS; b++)
+    {
+        uint32_t count = histogram[b];
+        if (count && cumulated + count >= rank)
+        {
+            float position = (rank - cumulated) / count;
+            return (b + position) * (1 << shift);
+        }
+        cumulated += count;
+    }
+    return 0;
+}